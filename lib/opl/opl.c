@@ -24,6 +24,7 @@
 #include "SDL.h"
 
 #include "opl.h"
+#include "opl3.h"
 #include "opl_internal.h"
 #include "m_misc.h"
 
@@ -42,6 +43,7 @@ static opl_driver_t *driver = NULL;
 static int init_stage_reg_writes = 1;
 
 unsigned int opl_sample_rate = 22050;
+int opl_offline_render = 0;
 
 //
 // Init/shutdown code.
@@ -96,6 +98,11 @@ static opl_init_result_t AutoSelectDriver(unsigned int port_base)
 
     for (i = 0; drivers[i] != NULL; ++i)
     {
+        if (opl_offline_render && drivers[i]->render_func == NULL)
+        {
+            continue;
+        }
+
         result = InitDriver(drivers[i], port_base);
         if (result != OPL_INIT_NONE)
         {
@@ -169,6 +176,24 @@ void OPL_SetSampleRate(unsigned int rate)
     opl_sample_rate = rate;
 }
 
+int OPL_SetSIMD(int enable)
+{
+    return OPL3_SetSIMD(enable);
+}
+
+void OPL_SetOfflineRender(int offline)
+{
+    opl_offline_render = offline;
+}
+
+void OPL_RenderOffline(int16_t *buffer, unsigned int frames)
+{
+    if (driver != NULL && driver->render_func != NULL)
+    {
+        driver->render_func(buffer, frames);
+    }
+}
+
 void OPL_WritePort(opl_port_t port, unsigned int value)
 {
     if (driver != NULL)
@@ -464,6 +489,15 @@ void OPL_Delay(uint64_t us)
         return;
     }
 
+    // Nothing else advances time when rendering offline.
+
+    if (opl_offline_render)
+    {
+        OPL_RenderOffline(NULL, (us * opl_sample_rate + OPL_SECOND - 1)
+                                / OPL_SECOND);
+        return;
+    }
+
     // Create a callback that will signal this thread after the
     // specified time.
 
@@ -85,6 +85,22 @@ void OPL_Shutdown(void);
 
 void OPL_SetSampleRate(unsigned int rate);
 
+// Use the SIMD (if built) or the scalar envelope pass in the software
+// emulator. Output is the same; returns whether SIMD is now in use.
+
+int OPL_SetSIMD(int enable);
+
+// Render to memory instead of the audio device: output is only
+// synthesised when OPL_RenderOffline asks for it, on the calling thread.
+// Must be set before OPL_Init.
+
+void OPL_SetOfflineRender(int offline);
+
+// Synthesise the given number of stereo frames in offline mode,
+// invoking callbacks as they become due.  A NULL buffer discards them.
+
+void OPL_RenderOffline(int16_t *buffer, unsigned int frames);
+
 // Write to one of the OPL I/O ports:
 
 void OPL_WritePort(opl_port_t port, unsigned int value);
@@ -89,6 +89,17 @@
  *   - Compatibility switches OPL_COMPAT_OLD_EG (pre-2024 envelope stepping)
  *     and OPL_COMPAT_DEFERRED_4OP_ALG (pre-Nov-2022 4-op routing update),
  *     both default-off; see opl3.h.
+ *   - Envelope generation for all 36 slots runs as one pass at the top of
+ *     each sample (OPL3_EnvelopeCalcAll), before any slot's phase and
+ *     output, over the structure-of-arrays chip->eg. With SSE2 it is
+ *     branch-free and processes 8 slots per step; otherwise it runs the
+ *     scalar OPL3_EnvelopeCalc per slot, skipping dormant ones. Both are
+ *     built where SSE2 is available, and OPL3_SetSIMD picks one at run
+ *     time. Envelope
+ *     inputs only change on register writes, and nothing a slot does in
+ *     its phase/output step feeds another slot's envelope, so hoisting
+ *     the pass is exact. The per-slot key-off and sustain fast paths,
+ *     which existed to skip the envelope, fold into the general path.
  */
 
 #include <stddef.h>
@@ -97,6 +108,17 @@
 #include <string.h>
 #include "opl3.h"
 
+#if !OPL_DISABLE_SIMD && (defined(__SSE2__) || defined(_M_X64) \
+                          || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define OPL_EG_SSE2 1
+#else
+#define OPL_EG_SSE2 0
+#endif
+
+/* Envelope pass in use, see OPL3_SetSIMD. */
+static int opl3_eg_simd = OPL_EG_SSE2;
+
 #if OPL_WF_TABLE_RUNTIME
 
 /* Base logsin quarter-wave table from upstream Nuked-OPL3. logsin_wf is
@@ -316,10 +338,13 @@ static void OPL3_EnvelopeUpdateKSL(opl3_slot *slot)
      * here, so this covers all dirty cases. */
     slot->eg_tl_ksl = (uint16_t)((slot->reg_tl << 2)
                               + (slot->eg_ksl >> kslshift[slot->reg_ksl]));
+    slot->chip->eg.tl_ksl[slot->slot_num] = slot->eg_tl_ksl;
 }
 
 static void OPL3_EnvelopeUpdateRate(opl3_slot *slot)
 {
+    opl3_eg *eg = &slot->chip->eg;
+    uint8_t n = slot->slot_num;
     uint8_t ii;
 
     slot->eg_ks = slot->channel->ksv >> ((slot->reg_ksr ^ 1) << 1);
@@ -331,52 +356,48 @@ static void OPL3_EnvelopeUpdateRate(opl3_slot *slot)
         {
             rate_hi = 0x0f;
         }
-        slot->eg_rate_hi[ii] = rate_hi;
-        slot->eg_rate_lo[ii] = rate & 0x03;
+        eg->rate_hi[ii][n] = rate_hi;
+        eg->rate_lo[ii][n] = rate & 0x03;
+        eg->rate_nz[ii][n] = slot->eg_rates[ii] ? 0xffff : 0;
     }
 }
 
-static void OPL3_EnvelopeCalc(opl3_slot *slot)
+/* Scalar envelope step for slot n. *trem is chip->tremolo or 0, per
+ * eg->trem. */
+static void OPL3_EnvelopeCalc(opl3_chip *chip, uint8_t n)
 {
+    opl3_eg *eg = &chip->eg;
     uint8_t nonzero;
     uint8_t rate_hi;
     uint8_t rate_lo;
-    uint8_t reg_rate = 0;
+    uint8_t idx;
     uint8_t eg_shift, shift;
     uint16_t eg_rout;
     int16_t eg_inc;
     uint8_t eg_off;
     uint8_t reset = 0;
 
-    slot->eg_out = slot->eg_rout + slot->eg_tl_ksl + *slot->trem;
-    if (slot->key && slot->eg_gen == envelope_gen_num_release)
+    eg->out[n] = eg->rout[n] + eg->tl_ksl[n] + (chip->tremolo & eg->trem[n]);
+    if (eg->key[n] && eg->gen[n] == envelope_gen_num_release)
     {
         reset = 1;
-        reg_rate = slot->eg_rates[0];
+        idx = 0;
     }
     else
     {
-        reg_rate = slot->eg_rates[slot->eg_gen];
+        idx = (uint8_t)eg->gen[n];
     }
-    slot->pg_reset = reset;
-    nonzero = (reg_rate != 0);
-    if (reset)
-    {
-        rate_hi = slot->eg_rate_hi[0];
-        rate_lo = slot->eg_rate_lo[0];
-    }
-    else
-    {
-        rate_hi = slot->eg_rate_hi[slot->eg_gen];
-        rate_lo = slot->eg_rate_lo[slot->eg_gen];
-    }
-    eg_shift = rate_hi + slot->chip->eg_add;
+    eg->pg_reset[n] = reset;
+    nonzero = (eg->rate_nz[idx][n] != 0);
+    rate_hi = (uint8_t)eg->rate_hi[idx][n];
+    rate_lo = (uint8_t)eg->rate_lo[idx][n];
+    eg_shift = rate_hi + chip->eg_add;
     shift = 0;
     if (nonzero)
     {
         if (rate_hi < 12)
         {
-            if (slot->chip->eg_state)
+            if (chip->eg_state)
             {
                 switch (eg_shift)
                 {
@@ -397,9 +418,9 @@ static void OPL3_EnvelopeCalc(opl3_slot *slot)
         else
         {
 #if OPL_COMPAT_OLD_EG
-            shift = (rate_hi & 0x03) + eg_incstep[rate_lo][slot->chip->timer & 0x03u];
+            shift = (rate_hi & 0x03) + eg_incstep[rate_lo][chip->timer & 0x03u];
 #else
-            shift = (rate_hi & 0x03) + eg_incstep[rate_lo][slot->chip->eg_timer_lo];
+            shift = (rate_hi & 0x03) + eg_incstep[rate_lo][chip->eg_timer_lo];
 #endif
             if (shift & 0x04)
             {
@@ -407,11 +428,11 @@ static void OPL3_EnvelopeCalc(opl3_slot *slot)
             }
             if (!shift)
             {
-                shift = slot->chip->eg_state;
+                shift = chip->eg_state;
             }
         }
     }
-    eg_rout = slot->eg_rout;
+    eg_rout = eg->rout[n];
     eg_inc = 0;
     eg_off = 0;
     /* Instant attack */
@@ -420,30 +441,30 @@ static void OPL3_EnvelopeCalc(opl3_slot *slot)
         eg_rout = 0x00;
     }
     /* Envelope off */
-    if ((slot->eg_rout & 0x1f8) == 0x1f8)
+    if ((eg->rout[n] & 0x1f8) == 0x1f8)
     {
         eg_off = 1;
     }
-    if (slot->eg_gen != envelope_gen_num_attack && !reset && eg_off)
+    if (eg->gen[n] != envelope_gen_num_attack && !reset && eg_off)
     {
         eg_rout = 0x1ff;
     }
-    switch (slot->eg_gen)
+    switch (eg->gen[n])
     {
     case envelope_gen_num_attack:
-        if (!slot->eg_rout)
+        if (!eg->rout[n])
         {
-            slot->eg_gen = envelope_gen_num_decay;
+            eg->gen[n] = envelope_gen_num_decay;
         }
-        else if (slot->key && shift > 0 && rate_hi != 0x0f)
+        else if (eg->key[n] && shift > 0 && rate_hi != 0x0f)
         {
-            eg_inc = ~slot->eg_rout >> (4 - shift);
+            eg_inc = ~eg->rout[n] >> (4 - shift);
         }
         break;
     case envelope_gen_num_decay:
-        if ((slot->eg_rout >> 4) == slot->reg_sl)
+        if ((eg->rout[n] >> 4) == eg->sl[n])
         {
-            slot->eg_gen = envelope_gen_num_sustain;
+            eg->gen[n] = envelope_gen_num_sustain;
         }
         else if (!eg_off && !reset && shift > 0)
         {
@@ -458,26 +479,213 @@ static void OPL3_EnvelopeCalc(opl3_slot *slot)
         }
         break;
     }
-    slot->eg_rout = (eg_rout + eg_inc) & 0x1ff;
+    eg->rout[n] = (eg_rout + eg_inc) & 0x1ff;
     /* Key off */
     if (reset)
     {
-        slot->eg_gen = envelope_gen_num_attack;
+        eg->gen[n] = envelope_gen_num_attack;
     }
-    if (!slot->key)
+    if (!eg->key[n])
     {
-        slot->eg_gen = envelope_gen_num_release;
+        eg->gen[n] = envelope_gen_num_release;
     }
 }
 
+#if OPL_EG_SSE2
+
+/* OPL3_EnvelopeCalc for 8 slots at once, branch-free: every case is
+ * computed and the per-slot result picked with masks. */
+static void OPL3_EnvelopeCalc8(opl3_chip *chip, uint8_t n)
+{
+    opl3_eg *eg = &chip->eg;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_cmpeq_epi16(zero, zero);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+    const __m128i three = _mm_set1_epi16(3);
+    const __m128i rate_f = _mm_set1_epi16(0x0f);
+    __m128i rout, gen, key, out, reset, m0, m1, m2, m3;
+    __m128i nz, hi, lo, shift, s_low, s_high, high, steps;
+    __m128i new_rout, eg_off, cond, inc, att_inc, lin_inc, notr;
+    __m128i is_att, is_dec, is_sr, rout_zero, sl_hit, shift_pos;
+    __m128i sh1, sh2, sh3, new_gen;
+    uint8_t timer_lo;
+
+#define LOAD(a) _mm_loadu_si128((const __m128i *)&(a)[n])
+#define SEL(m, a, b) _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+#define SEL4(a) _mm_or_si128(_mm_or_si128(_mm_and_si128(m0, LOAD(a[0])), \
+                                          _mm_and_si128(m1, LOAD(a[1]))), \
+                             _mm_or_si128(_mm_and_si128(m2, LOAD(a[2])), \
+                                          _mm_and_si128(m3, LOAD(a[3]))))
+
+    rout = LOAD(eg->rout);
+    gen = LOAD(eg->gen);
+    key = LOAD(eg->key);
+
+    out = _mm_add_epi16(_mm_add_epi16(rout, LOAD(eg->tl_ksl)),
+                        _mm_and_si128(LOAD(eg->trem),
+                                      _mm_set1_epi16(chip->tremolo)));
+    _mm_storeu_si128((__m128i *)&eg->out[n], out);
+
+    /* Key on during release restarts the envelope with the attack rate */
+    reset = _mm_and_si128(key, _mm_cmpeq_epi16(gen, three));
+    _mm_storeu_si128((__m128i *)&eg->pg_reset[n], _mm_srli_epi16(reset, 15));
+
+    m0 = _mm_or_si128(reset, _mm_cmpeq_epi16(gen, zero));
+    m1 = _mm_andnot_si128(reset, _mm_cmpeq_epi16(gen, one));
+    m2 = _mm_andnot_si128(reset, _mm_cmpeq_epi16(gen, two));
+    m3 = _mm_andnot_si128(reset, _mm_cmpeq_epi16(gen, three));
+    nz = SEL4(eg->rate_nz);
+    hi = SEL4(eg->rate_hi);
+    lo = SEL4(eg->rate_lo);
+
+    /* rate_hi < 12: steps on every 2^n-th eg_state cycle */
+    if (chip->eg_state)
+    {
+        __m128i eg_shift = _mm_add_epi16(hi, _mm_set1_epi16(chip->eg_add));
+        s_low = _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi16(eg_shift, _mm_set1_epi16(12)), one),
+            _mm_or_si128(
+                _mm_and_si128(_mm_cmpeq_epi16(eg_shift, _mm_set1_epi16(13)),
+                              _mm_and_si128(_mm_srli_epi16(lo, 1), one)),
+                _mm_and_si128(_mm_cmpeq_epi16(eg_shift, _mm_set1_epi16(14)),
+                              _mm_and_si128(lo, one))));
+    }
+    else
+    {
+        s_low = zero;
+    }
+
+    /* rate_hi >= 12: steps every sample */
+#if OPL_COMPAT_OLD_EG
+    timer_lo = chip->timer & 0x03u;
+#else
+    timer_lo = chip->eg_timer_lo;
+#endif
+    steps = _mm_or_si128(
+        _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi16(lo, zero),
+                          _mm_set1_epi16(eg_incstep[0][timer_lo])),
+            _mm_and_si128(_mm_cmpeq_epi16(lo, one),
+                          _mm_set1_epi16(eg_incstep[1][timer_lo]))),
+        _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi16(lo, two),
+                          _mm_set1_epi16(eg_incstep[2][timer_lo])),
+            _mm_and_si128(_mm_cmpeq_epi16(lo, three),
+                          _mm_set1_epi16(eg_incstep[3][timer_lo]))));
+    s_high = _mm_min_epi16(_mm_add_epi16(_mm_and_si128(hi, three), steps),
+                           three);
+    s_high = _mm_or_si128(s_high,
+                          _mm_and_si128(_mm_cmpeq_epi16(s_high, zero),
+                                        _mm_set1_epi16(chip->eg_state)));
+
+    high = _mm_cmpgt_epi16(hi, _mm_set1_epi16(11));
+    shift = _mm_and_si128(nz, SEL(high, s_high, s_low));
+    shift_pos = _mm_cmpgt_epi16(shift, zero);
+    sh1 = _mm_cmpeq_epi16(shift, one);
+    sh2 = _mm_cmpeq_epi16(shift, two);
+    sh3 = _mm_cmpeq_epi16(shift, three);
+
+    /* Instant attack */
+    new_rout = _mm_andnot_si128(
+        _mm_and_si128(reset, _mm_cmpeq_epi16(hi, rate_f)), rout);
+
+    /* Envelope off */
+    eg_off = _mm_cmpeq_epi16(_mm_and_si128(rout, _mm_set1_epi16(0x1f8)),
+                             _mm_set1_epi16(0x1f8));
+    is_att = _mm_cmpeq_epi16(gen, zero);
+    cond = _mm_andnot_si128(_mm_or_si128(is_att, reset), eg_off);
+    new_rout = SEL(cond, _mm_set1_epi16(0x1ff), new_rout);
+
+    /* Attack: inc = ~rout >> (4 - shift) */
+    rout_zero = _mm_cmpeq_epi16(rout, zero);
+    notr = _mm_xor_si128(rout, ones);
+    att_inc = _mm_or_si128(
+        _mm_and_si128(sh1, _mm_srai_epi16(notr, 3)),
+        _mm_or_si128(_mm_and_si128(sh2, _mm_srai_epi16(notr, 2)),
+                     _mm_and_si128(sh3, _mm_srai_epi16(notr, 1))));
+    cond = _mm_and_si128(_mm_andnot_si128(rout_zero, is_att),
+                         _mm_and_si128(key, shift_pos));
+    cond = _mm_andnot_si128(_mm_cmpeq_epi16(hi, rate_f), cond);
+    inc = _mm_and_si128(cond, att_inc);
+
+    /* Decay, sustain, release: inc = 1 << (shift - 1) */
+    is_dec = _mm_cmpeq_epi16(gen, one);
+    is_sr = _mm_cmpgt_epi16(gen, one);
+    sl_hit = _mm_cmpeq_epi16(_mm_srli_epi16(rout, 4), LOAD(eg->sl));
+    lin_inc = _mm_or_si128(_mm_and_si128(sh1, one),
+                           _mm_or_si128(_mm_and_si128(sh2, two),
+                                        _mm_and_si128(sh3,
+                                                      _mm_set1_epi16(4))));
+    cond = _mm_or_si128(_mm_andnot_si128(sl_hit, is_dec), is_sr);
+    cond = _mm_andnot_si128(_mm_or_si128(eg_off, reset),
+                            _mm_and_si128(cond, shift_pos));
+    inc = _mm_or_si128(inc, _mm_and_si128(cond, lin_inc));
+
+    _mm_storeu_si128((__m128i *)&eg->rout[n],
+                     _mm_and_si128(_mm_add_epi16(new_rout, inc),
+                                   _mm_set1_epi16(0x1ff)));
+
+    /* Generator transitions, then key on/off */
+    new_gen = SEL(_mm_and_si128(is_att, rout_zero), one, gen);
+    new_gen = SEL(_mm_and_si128(is_dec, sl_hit), two, new_gen);
+    new_gen = _mm_andnot_si128(reset, new_gen);
+    new_gen = SEL(key, new_gen, three);
+    _mm_storeu_si128((__m128i *)&eg->gen[n], new_gen);
+
+#undef LOAD
+#undef SEL
+#undef SEL4
+}
+
+#endif /* OPL_EG_SSE2 */
+
+/* Envelope step for every slot, run before any slot is processed. */
+static void OPL3_EnvelopeCalcAll(opl3_chip *chip)
+{
+    uint32_t write_gen = chip->write_gen;
+    uint8_t n;
+
+#if OPL_EG_SSE2
+    if (opl3_eg_simd)
+    {
+        /* Dormant slots come through unchanged, so they need no skipping */
+        for (n = 0; n < OPL_EG_SLOTS; n += 8)
+        {
+            OPL3_EnvelopeCalc8(chip, n);
+        }
+        return;
+    }
+#endif
+
+    for (n = 0; n < 36; n++)
+    {
+        if (chip->slot[n].dormant_gen != write_gen)
+        {
+            OPL3_EnvelopeCalc(chip, n);
+        }
+    }
+}
+
+/* Both passes leave the same state behind, so the choice can change at
+ * any time. Returns whether the SIMD pass is now in use. */
+int OPL3_SetSIMD(int enable)
+{
+    opl3_eg_simd = OPL_EG_SSE2 && enable;
+
+    return opl3_eg_simd;
+}
+
 static void OPL3_EnvelopeKeyOn(opl3_slot *slot, uint8_t type)
 {
     slot->key |= type;
+    slot->chip->eg.key[slot->slot_num] = slot->key ? 0xffff : 0;
 }
 
 static void OPL3_EnvelopeKeyOff(opl3_slot *slot, uint8_t type)
 {
     slot->key &= ~type;
+    slot->chip->eg.key[slot->slot_num] = slot->key ? 0xffff : 0;
 }
 
 /*
@@ -535,7 +743,7 @@ static inline void OPL3_PhaseGenerateImpl(opl3_slot *slot, int maybe_rhythm)
         phaseinc = slot->pg_inc;
     }
     phase = (uint16_t)(slot->pg_phase >> 9);
-    if (slot->pg_reset)
+    if (chip->eg.pg_reset[slot->slot_num])
     {
         slot->pg_phase = 0;
     }
@@ -603,10 +811,12 @@ static void OPL3_SlotWrite20(opl3_slot *slot, uint8_t data)
     if ((data >> 7) & 0x01)
     {
         slot->trem = &slot->chip->tremolo;
+        slot->chip->eg.trem[slot->slot_num] = 0xffff;
     }
     else
     {
         slot->trem = (uint8_t*)&slot->chip->zeromod;
+        slot->chip->eg.trem[slot->slot_num] = 0;
     }
     slot->reg_vib = (data >> 6) & 0x01;
     slot->reg_type = (data >> 5) & 0x01;
@@ -640,6 +850,7 @@ static void OPL3_SlotWrite80(opl3_slot *slot, uint8_t data)
     {
         slot->reg_sl = 0x1f;
     }
+    slot->chip->eg.sl[slot->slot_num] = slot->reg_sl;
     slot->reg_rr = data & 0x0f;
     slot->eg_rates[2] = slot->reg_type ? 0 : slot->reg_rr;
     slot->eg_rates[3] = slot->reg_rr;
@@ -658,7 +869,7 @@ static void OPL3_SlotWriteE0(opl3_slot *slot, uint8_t data)
 static inline void OPL3_SlotGenerate(opl3_slot *slot)
 {
     uint16_t phase = slot->pg_phase_out + *slot->mod;
-    uint16_t envelope = slot->eg_out;
+    uint16_t envelope = slot->chip->eg.out[slot->slot_num];
     uint16_t wf_data = logsin_wf[slot->reg_wf][phase & 0x3ff];
     uint16_t neg = (uint16_t)(((int16_t)wf_data) >> 15);
     uint32_t level = (wf_data & 0x7fff) + (envelope << 3);
@@ -672,7 +883,8 @@ static inline void OPL3_SlotGenerate(opl3_slot *slot)
 /* Silent-regime variant: when the caller has proven eg_out >= 0x180, the
  * exprom lookup always reads through to zero (max exprom value 0xff4 >> 12
  * = 0), so the final out reduces to just the sign bit of wf_data. Skips a
- * load, an add, a clamp, a shift, and a xor. */
+ * load, an add, a clamp, a shift, and a xor. Used for every slot that is
+ * that far attenuated. */
 static inline void OPL3_SlotGenerateSilent(opl3_slot *slot)
 {
     uint16_t phase = slot->pg_phase_out + *slot->mod;
@@ -1213,88 +1425,19 @@ static int16_t OPL3_ClipSample(int32_t sample)
     return (int16_t)sample;
 }
 
+/* The envelope has already been stepped by OPL3_EnvelopeCalcAll. */
 static inline void OPL3_ProcessSlotImpl(opl3_slot *slot, uint8_t fb, int maybe_rhythm)
 {
-    /* Fast path for fully-attenuated key-off non-rhythm slots. The envelope
-     * rate machine cannot change eg_rout here, but the full path still updates
-     * feedback history, eg_out/eg_gen/pg_reset, phase output, noise, and out. */
-    if (!slot->key && slot->eg_rout == 0x1ff
-        && (!maybe_rhythm
-            || (slot->slot_num != 13 && slot->slot_num != 16 && slot->slot_num != 17)))
+    OPL3_SlotCalcFB(slot, fb);
+    OPL3_PhaseGenerateImpl(slot, maybe_rhythm);
+    if (slot->chip->eg.out[slot->slot_num] >= 0x180)
     {
-        opl3_chip *chip = slot->chip;
-        uint32_t phaseinc;
-        uint16_t phase;
-
-        if (fb == 0 && slot->pg_inc == 0 && slot->out == 0
-            && *slot->mod == 0 && slot->eg_tl_ksl == 0 && *slot->trem == 0
-            && slot->pg_phase == 0 && slot->reg_vib == 0 && slot->reg_wf == 0)
-        {
-            slot->fbmod = 0;
-            slot->prout = 0;
-            slot->eg_out = 0x1ff;
-            slot->pg_reset = 0;
-            slot->eg_gen = envelope_gen_num_release;
-            slot->pg_phase_out = 0;
-            return;
-        }
-
-        OPL3_SlotCalcFB(slot, fb);
-
-        slot->eg_out = slot->eg_rout + slot->eg_tl_ksl + *slot->trem;
-        slot->pg_reset = 0;
-        slot->eg_gen = envelope_gen_num_release;
-
-        if (slot->reg_vib)
-        {
-            phaseinc = slot->pg_inc_vib[chip->vibpos];
-        }
-        else
-        {
-            phaseinc = slot->pg_inc;
-        }
-
-        phase = (uint16_t)(slot->pg_phase >> 9);
-        slot->pg_phase += phaseinc;
-        slot->pg_phase_out = phase;
-
-        /* eg_out = eg_rout + eg_tl_ksl + *trem >= 0x1ff here, so the
-         * silent-regime shortcut is always valid. */
         OPL3_SlotGenerateSilent(slot);
-        return;
     }
-    if (slot->eg_gen == envelope_gen_num_sustain && slot->key
-        && slot->eg_rates[envelope_gen_num_sustain] == 0)
+    else
     {
-        OPL3_SlotCalcFB(slot, fb);
-        slot->eg_out = slot->eg_rout + slot->eg_tl_ksl + *slot->trem;
-        slot->pg_reset = 0;
-        if ((slot->eg_rout & 0x1f8) == 0x1f8)
-        {
-            slot->eg_rout = 0x1ff;
-        }
-
-        if (!slot->reg_vib
-            && (!maybe_rhythm
-                || (slot->slot_num != 13 && slot->slot_num != 16 && slot->slot_num != 17)))
-        {
-            uint16_t phase = (uint16_t)(slot->pg_phase >> 9);
-
-            slot->pg_phase += slot->pg_inc;
-            slot->pg_phase_out = phase;
-        }
-        else
-        {
-            OPL3_PhaseGenerateImpl(slot, maybe_rhythm);
-        }
-
         OPL3_SlotGenerate(slot);
-        return;
     }
-    OPL3_SlotCalcFB(slot, fb);
-    OPL3_EnvelopeCalc(slot);
-    OPL3_PhaseGenerateImpl(slot, maybe_rhythm);
-    OPL3_SlotGenerate(slot);
 }
 
 /* Out-of-line clones of OPL3_ProcessSlotImpl. Norm is for the 16 channels
@@ -1314,18 +1457,22 @@ static void OPL3_ProcessSlotRhythm(opl3_slot *slot, uint8_t fb)
  * The prout == 0 and eg_gen == release conditions are critical because their
  * silence values are not implied by the other conditions (a key-on pulse with
  * AR=0 parks eg_gen in attack; prout can hold the last pre-silence output),
- * so the transition sample runs the trivial path inside ProcessSlot, which
- * writes both. The remaining fields the trivial path writes (fbmod, eg_out,
- * pg_reset, pg_phase_out) are recomputed by every ProcessSlot tier. */
+ * so the transition sample runs ProcessSlot, which writes both. The check
+ * sees the envelope state after this sample's step; a slot passing it one
+ * sample earlier than before is harmless, as processing it would only write
+ * the zeros it already holds. The remaining fields ProcessSlot writes
+ * (fbmod, pg_phase_out) are recomputed before anything reads them. */
 static inline void OPL3_ProcessSlotMaybeInline(opl3_slot *slot, uint8_t fb, int maybe_rhythm,
                                                uint32_t write_gen)
 {
+    opl3_eg *eg = &slot->chip->eg;
+
     if (slot->dormant_gen == write_gen)
     {
         return;
     }
-    if (!slot->key && slot->eg_rout == 0x1ff
-        && slot->eg_gen == envelope_gen_num_release
+    if (!slot->key && eg->rout[slot->slot_num] == 0x1ff
+        && eg->gen[slot->slot_num] == envelope_gen_num_release
         && (!maybe_rhythm
             || (slot->slot_num != 13 && slot->slot_num != 16 && slot->slot_num != 17))
         && fb == 0 && slot->pg_inc == 0 && slot->out == 0
@@ -1465,6 +1612,8 @@ inline static void OPL3_Generate4Ch(opl3_chip *chip, int16_t *buf4)
                     | (f32_35 << 19);
     }
 
+    OPL3_EnvelopeCalcAll(chip);
+
     /* Process all 36 slots (channel-grouped pairs) before either mix pass.
      * The mixes read the delayed slots' previous-sample out through prout
      * via the out_left/out_right pointer lists. */
@@ -1680,14 +1829,17 @@ void OPL3_Reset(opl3_chip *chip, uint32_t samplerate)
     }
 #endif
     memset(chip, 0, sizeof(opl3_chip));
+    for (slotnum = 0; slotnum < OPL_EG_SLOTS; slotnum++)
+    {
+        chip->eg.rout[slotnum] = 0x1ff;
+        chip->eg.out[slotnum] = 0x1ff;
+        chip->eg.gen[slotnum] = envelope_gen_num_release;
+    }
     for (slotnum = 0; slotnum < 36; slotnum++)
     {
         slot = &chip->slot[slotnum];
         slot->chip = chip;
         slot->mod = &chip->zeromod;
-        slot->eg_rout = 0x1ff;
-        slot->eg_out = 0x1ff;
-        slot->eg_gen = envelope_gen_num_release;
         slot->trem = (uint8_t*)&chip->zeromod;
         slot->eg_rates[0] = slot->eg_rates[1] = slot->eg_rates[2] = slot->eg_rates[3] = 0;
         slot->slot_num = slotnum;
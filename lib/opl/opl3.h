@@ -54,6 +54,11 @@
  *     table in place of wf_rom.h).
  *   - Added the OPL_COMPAT_OLD_EG and OPL_COMPAT_DEFERRED_4OP_ALG build
  *     options (parity with older upstream commits).
+ *   - Moved the envelope generator state (eg_rout, eg_out, eg_gen,
+ *     pg_reset, eg_rate_hi, eg_rate_lo) from opl3_slot into the
+ *     structure-of-arrays opl3_eg on the chip, with mirrors of the
+ *     envelope inputs, for the SIMD envelope pass. Added the
+ *     OPL_DISABLE_SIMD build option and OPL3_SetSIMD.
  */
 
 #ifndef OPL_OPL3_H
@@ -105,9 +110,19 @@ extern "C" {
 #define OPL_COMPAT_DEFERRED_4OP_ALG 0
 #endif
 
+/* OPL_DISABLE_SIMD=1 leaves the SSE2 envelope pass out of the build, so
+ * only the scalar one is left; OPL3_SetSIMD switches between them at run
+ * time. Output is identical either way. */
+#ifndef OPL_DISABLE_SIMD
+#define OPL_DISABLE_SIMD 0
+#endif
+
 #define OPL_WRITEBUF_SIZE   1024
 #define OPL_WRITEBUF_DELAY  2
 
+/* Slots in the envelope arrays: 36, padded to a multiple of 8 */
+#define OPL_EG_SLOTS        40
+
 typedef struct _opl3_slot opl3_slot;
 typedef struct _opl3_channel opl3_channel;
 typedef struct _opl3_chip opl3_chip;
@@ -117,7 +132,6 @@ struct _opl3_slot {
     opl3_chip *chip;
     int16_t *mod;
     uint8_t *trem;
-    uint32_t pg_reset;
     uint32_t pg_phase;
     uint32_t pg_inc;
     /* Equal to chip->write_gen while the slot is provably inert: fully
@@ -128,15 +142,12 @@ struct _opl3_slot {
     int16_t out;
     int16_t fbmod;
     int16_t prout;
-    uint16_t eg_rout;
-    uint16_t eg_out;
     /* Cached (reg_tl << 2) + (eg_ksl >> kslshift[reg_ksl]); maintained by
      * OPL3_EnvelopeUpdateKSL whenever any of those inputs change. Hoists
      * a load + lookup + shift out of the per-sample envelope hot path. */
     uint16_t eg_tl_ksl;
     uint16_t pg_phase_out;
     uint8_t key;
-    uint8_t eg_gen;
     uint8_t reg_vib;
     uint8_t reg_mult;
     uint8_t reg_wf;
@@ -152,8 +163,6 @@ struct _opl3_slot {
     uint8_t reg_sl;
     uint8_t reg_rr;
     uint8_t eg_rates[4];
-    uint8_t eg_rate_hi[4];
-    uint8_t eg_rate_lo[4];
     /* Phase increment per vibrato position, maintained by
      * OPL3_PhaseUpdateInc (and rebuilt on vibshift changes); pg_inc_vib[pos]
      * equals the upstream per-sample vibrato f_num adjustment for that pos. */
@@ -194,6 +203,24 @@ struct _opl3_channel {
     uint8_t ch_num;
 };
 
+/* Envelope generator state of all slots, indexed by slot_num, processed
+ * for every slot at once at the top of each sample. rout, out, gen and
+ * pg_reset are the state proper; the rest mirror slot registers and are
+ * updated on the writes that change them. Masks are 0 or 0xffff. */
+typedef struct _opl3_eg {
+    uint16_t rout[OPL_EG_SLOTS];
+    uint16_t out[OPL_EG_SLOTS];
+    uint16_t gen[OPL_EG_SLOTS];
+    uint16_t pg_reset[OPL_EG_SLOTS];
+    uint16_t key[OPL_EG_SLOTS];         /* key != 0 */
+    uint16_t tl_ksl[OPL_EG_SLOTS];      /* eg_tl_ksl */
+    uint16_t sl[OPL_EG_SLOTS];          /* reg_sl */
+    uint16_t trem[OPL_EG_SLOTS];        /* trem points at tremolo */
+    uint16_t rate_nz[4][OPL_EG_SLOTS];  /* eg_rates[i] != 0 */
+    uint16_t rate_hi[4][OPL_EG_SLOTS];
+    uint16_t rate_lo[4][OPL_EG_SLOTS];
+} opl3_eg;
+
 typedef struct _opl3_writebuf {
     uint64_t time;
     uint16_t reg;
@@ -203,6 +230,7 @@ typedef struct _opl3_writebuf {
 struct _opl3_chip {
     opl3_channel channel[18];
     opl3_slot slot[36];
+    opl3_eg eg;
     uint16_t timer;
     uint64_t eg_timer;
     uint8_t eg_timerrem;
@@ -271,6 +299,8 @@ void OPL3_GenerateStream(opl3_chip *chip, int16_t *sndptr, uint32_t numsamples);
 void OPL3_Generate4ChResampled(opl3_chip *chip, int16_t *buf4);
 void OPL3_Generate4ChStream(opl3_chip *chip, int16_t *sndptr1, int16_t *sndptr2, uint32_t numsamples);
 
+int OPL3_SetSIMD(int enable);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,7 @@ typedef void (*opl_lock_func)(void);
 typedef void (*opl_unlock_func)(void);
 typedef void (*opl_set_paused_func)(int paused);
 typedef void (*opl_adjust_callbacks_func)(float value);
+typedef void (*opl_render_func)(int16_t *buffer, unsigned int frames);
 
 typedef struct
 {
@@ -48,12 +49,17 @@ typedef struct
     opl_unlock_func unlock_func;
     opl_set_paused_func set_paused_func;
     opl_adjust_callbacks_func adjust_callbacks_func;
+    opl_render_func render_func;  // NULL if offline rendering unsupported
 } opl_driver_t;
 
 // Sample rate to use when doing software emulation.
 
 extern unsigned int opl_sample_rate;
 
+// Non-zero if output is rendered with OPL_RenderOffline.
+
+extern int opl_offline_render;
+
 
 #if (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IOPERM)
 extern opl_driver_t opl_linux_driver;
@@ -41,6 +41,11 @@
 
 #define MAX_SOUND_SLICE_TIME 100 /* ms */
 
+// Output is synthesised this far ahead of what the audio callback
+// will ask for next.
+
+#define RENDER_AHEAD_TIME 10 /* ms */
+
 typedef struct
 {
     unsigned int rate;        // Number of times the timer is advanced per sec.
@@ -80,9 +85,43 @@ static uint64_t pause_offset;
 static opl3_chip opl_chip;
 static int opl_opl3mode;
 
-// Temporary mixing buffer used by the mixing callback.
+// Synthesis runs on its own thread, ahead of the audio callback, which
+// only copies from this ring buffer of stereo frames. Positions count
+// frames and wrap; the render thread alone advances render_write_pos
+// and the callback alone render_read_pos.
+
+static int16_t *render_buffer = NULL;
+static unsigned int render_buffer_frames;
+static SDL_atomic_t render_write_pos;
+static SDL_atomic_t render_read_pos;
+
+// Frames the audio callback asked for last time.
+
+static SDL_atomic_t render_callback_frames;
+static unsigned int render_ahead_frames;
+
+// Set at init if output is pulled with OPL_RenderOffline; there is then
+// no render thread and the ring buffer is drained as soon as it is filled.
+
+static int render_offline;
+
+static SDL_Thread *render_thread = NULL;
+static SDL_threadID render_thread_id;
+static SDL_sem *render_sem = NULL;
+static SDL_atomic_t render_quit;
+
+// Register writes made from threads other than the render thread,
+// applied by the render thread before it synthesises more output.
+
+typedef struct
+{
+    uint16_t reg;
+    uint8_t value;
+} opl_write_t;
 
-static uint8_t *mix_buffer = NULL;
+static opl_write_t *write_queue = NULL;
+static unsigned int write_queue_len, write_queue_size;
+static SDL_mutex *write_queue_mutex = NULL;
 
 // Register number that was written.
 
@@ -107,6 +146,25 @@ static int SDLIsInitialized(void)
     return Mix_QuerySpec(&freq, &format, &channels);
 }
 
+// Apply register writes queued by other threads.
+
+static void ApplyQueuedWrites(void)
+{
+    unsigned int i;
+
+    SDL_LockMutex(write_queue_mutex);
+
+    for (i = 0; i < write_queue_len; ++i)
+    {
+        OPL3_WriteRegBuffered(&opl_chip, write_queue[i].reg,
+                              write_queue[i].value);
+    }
+
+    write_queue_len = 0;
+
+    SDL_UnlockMutex(write_queue_mutex);
+}
+
 // Advance time by the specified number of samples, invoking any
 // callback functions as appropriate.
 
@@ -151,6 +209,9 @@ static void AdvanceTime(unsigned int nsamples)
         SDL_UnlockMutex(callback_queue_mutex);
 
         SDL_LockMutex(callback_mutex);
+        // Writes the game thread queued before this point must land
+        // before the callback's own writes, which take effect at once.
+        ApplyQueuedWrites();
         callback(callback_data);
         SDL_UnlockMutex(callback_mutex);
 
@@ -160,35 +221,45 @@ static void AdvanceTime(unsigned int nsamples)
     SDL_UnlockMutex(callback_queue_mutex);
 }
 
-// Call the OPL emulator code to fill the specified buffer.
+// Call the OPL emulator code to fill the ring buffer from the current
+// write position. The caller checks there is room.
 
-static void FillBuffer(uint8_t *buffer, unsigned int nsamples)
+static void FillBuffer(unsigned int nsamples)
 {
-    // This seems like a reasonable assumption.  mix_buffer is
-    // 1 second long, which should always be much longer than the
-    // SDL mix buffer.
-    assert(nsamples < mixing_freq);
-
-    // OPL output is generated into temporary buffer and then mixed
-    // (to avoid overflows etc.)
-    OPL3_GenerateStream(&opl_chip, (int16_t *) mix_buffer, nsamples);
-    SDL_MixAudioFormat(buffer, mix_buffer, AUDIO_S16SYS, nsamples * 4,
-                       SDL_MIX_MAXVOLUME);
+    unsigned int pos, count;
+
+    ApplyQueuedWrites();
+
+    pos = (unsigned int) SDL_AtomicGet(&render_write_pos);
+
+    while (nsamples > 0)
+    {
+        const unsigned int offset = pos & (render_buffer_frames - 1);
+
+        count = render_buffer_frames - offset;
+
+        if (count > nsamples)
+        {
+            count = nsamples;
+        }
+
+        OPL3_GenerateStream(&opl_chip, render_buffer + offset * 2, count);
+
+        pos += count;
+        nsamples -= count;
+    }
+
+    SDL_AtomicSet(&render_write_pos, (int) pos);
 }
 
-// Callback function to fill a new sound buffer:
+// Synthesise the given number of frames, invoking callbacks in between
+// as they become due.
 
-static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+static void RenderFrames(unsigned int frames)
 {
-    unsigned int filled, buffer_samples;
-    Uint8 *buffer = (Uint8*)stream;
-
-    // Repeatedly call the OPL emulator update function until the buffer is
-    // full.
-    filled = 0;
-    buffer_samples = len / 4;
+    unsigned int filled = 0;
 
-    while (filled < buffer_samples)
+    while (filled < frames)
     {
         uint64_t next_callback_time;
         uint64_t nsamples;
@@ -201,7 +272,7 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
 
         if (opl_sdl_paused || OPL_Queue_IsEmpty(callback_queue))
         {
-            nsamples = buffer_samples - filled;
+            nsamples = frames - filled;
         }
         else
         {
@@ -210,9 +281,9 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
             nsamples = (next_callback_time - current_time) * mixing_freq;
             nsamples = (nsamples + OPL_SECOND - 1) / OPL_SECOND;
 
-            if (nsamples > buffer_samples - filled)
+            if (nsamples > frames - filled)
             {
-                nsamples = buffer_samples - filled;
+                nsamples = frames - filled;
             }
         }
 
@@ -220,7 +291,7 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
 
         // Add emulator output to buffer.
 
-        FillBuffer(buffer + filled * 4, nsamples);
+        FillBuffer(nsamples);
         filled += nsamples;
 
         // Invoke callbacks for this point in time.
@@ -229,19 +300,157 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
     }
 }
 
+// Render thread: keeps the ring buffer filled with one callback's worth
+// of output plus the render-ahead margin.
+
+static int RenderThread(void *unused)
+{
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+    while (!SDL_AtomicGet(&render_quit))
+    {
+        unsigned int target, fill;
+
+        target = (unsigned int) SDL_AtomicGet(&render_callback_frames)
+               + render_ahead_frames;
+
+        if (target > render_buffer_frames)
+        {
+            target = render_buffer_frames;
+        }
+
+        fill = (unsigned int) SDL_AtomicGet(&render_write_pos)
+             - (unsigned int) SDL_AtomicGet(&render_read_pos);
+
+        if (fill >= target)
+        {
+            SDL_SemWaitTimeout(render_sem, RENDER_AHEAD_TIME);
+            continue;
+        }
+
+        RenderFrames(target - fill);
+    }
+
+    return 0;
+}
+
+// Callback function to fill a new sound buffer. Only copies what the
+// render thread has synthesised; if it fell behind, the rest of the
+// buffer gets no music.
+
+static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+{
+    Uint8 *buffer = (Uint8*)stream;
+    unsigned int buffer_samples, available, pos;
+
+    buffer_samples = len / 4;
+
+    pos = (unsigned int) SDL_AtomicGet(&render_read_pos);
+    available = (unsigned int) SDL_AtomicGet(&render_write_pos) - pos;
+
+    if (available > buffer_samples)
+    {
+        available = buffer_samples;
+    }
+
+    while (available > 0)
+    {
+        const unsigned int offset = pos & (render_buffer_frames - 1);
+        unsigned int count = render_buffer_frames - offset;
+
+        if (count > available)
+        {
+            count = available;
+        }
+
+        SDL_MixAudioFormat(buffer, (Uint8 *) (render_buffer + offset * 2),
+                           AUDIO_S16SYS, count * 4, SDL_MIX_MAXVOLUME);
+
+        buffer += count * 4;
+        pos += count;
+        available -= count;
+    }
+
+    SDL_AtomicSet(&render_read_pos, (int) pos);
+    SDL_AtomicSet(&render_callback_frames, (int) buffer_samples);
+    SDL_SemPost(render_sem);
+}
+
+// Offline rendering: synthesise into the ring buffer and copy straight
+// out of it.
+
+static void OPL_SDL_Render(int16_t *buffer, unsigned int frames)
+{
+    while (frames > 0)
+    {
+        unsigned int pos, count, offset, part;
+
+        count = frames < render_buffer_frames ? frames : render_buffer_frames;
+
+        RenderFrames(count);
+
+        pos = (unsigned int) SDL_AtomicGet(&render_read_pos);
+        offset = pos & (render_buffer_frames - 1);
+        part = render_buffer_frames - offset;
+
+        if (part > count)
+        {
+            part = count;
+        }
+
+        if (buffer != NULL)
+        {
+            memcpy(buffer, render_buffer + offset * 2, part * 4);
+            memcpy(buffer + part * 2, render_buffer, (count - part) * 4);
+            buffer += count * 2;
+        }
+
+        SDL_AtomicSet(&render_read_pos, (int) (pos + count));
+        frames -= count;
+    }
+}
+
 static void OPL_SDL_Shutdown(void)
 {
-    Mix_HookMusic(NULL, NULL);
+    if (!render_offline)
+    {
+        Mix_HookMusic(NULL, NULL);
+        Mix_UnregisterEffect(MIX_CHANNEL_POST, OPL_Mix_Callback);
+    }
+
+    if (render_thread != NULL)
+    {
+        SDL_AtomicSet(&render_quit, 1);
+        SDL_SemPost(render_sem);
+        SDL_WaitThread(render_thread, NULL);
+        render_thread = NULL;
+    }
+
+    if (render_sem != NULL)
+    {
+        SDL_DestroySemaphore(render_sem);
+        render_sem = NULL;
+    }
 
     if (sdl_was_initialized)
     {
         Mix_CloseAudio();
         SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        OPL_Queue_Destroy(callback_queue);
-        free(mix_buffer);
         sdl_was_initialized = 0;
     }
 
+    if (callback_queue != NULL)
+    {
+        OPL_Queue_Destroy(callback_queue);
+        callback_queue = NULL;
+    }
+
+    free(render_buffer);
+    render_buffer = NULL;
+    free(write_queue);
+    write_queue = NULL;
+    write_queue_len = write_queue_size = 0;
+
 /*
     if (opl_chip != NULL)
     {
@@ -261,6 +470,12 @@ static void OPL_SDL_Shutdown(void)
         SDL_DestroyMutex(callback_queue_mutex);
         callback_queue_mutex = NULL;
     }
+
+    if (write_queue_mutex != NULL)
+    {
+        SDL_DestroyMutex(write_queue_mutex);
+        write_queue_mutex = NULL;
+    }
 }
 
 static unsigned int GetSliceSize(void)
@@ -289,10 +504,18 @@ static unsigned int GetSliceSize(void)
 
 static int OPL_SDL_Init(unsigned int port_base)
 {
+    render_offline = opl_offline_render;
+
     // Check if SDL_mixer has been opened already
     // If not, we must initialize it now
 
-    if (!SDLIsInitialized())
+    if (render_offline)
+    {
+        // No audio device needed.
+
+        sdl_was_initialized = 0;
+    }
+    else if (!SDLIsInitialized())
     {
         if (SDL_Init(SDL_INIT_AUDIO) < 0)
         {
@@ -330,7 +553,16 @@ static int OPL_SDL_Init(unsigned int port_base)
 
     // Get the mixer frequency, format and number of channels.
 
-    Mix_QuerySpec(&mixing_freq, &mixing_format, &mixing_channels);
+    if (render_offline)
+    {
+        mixing_freq = opl_sample_rate;
+        mixing_format = AUDIO_S16SYS;
+        mixing_channels = 2;
+    }
+    else
+    {
+        Mix_QuerySpec(&mixing_freq, &mixing_format, &mixing_channels);
+    }
 
     // Only supports AUDIO_S16SYS
 
@@ -344,8 +576,29 @@ static int OPL_SDL_Init(unsigned int port_base)
         return 0;
     }
 
-    // Mix buffer: four bytes per sample (16 bits * 2 channels):
-    mix_buffer = malloc(mixing_freq * 4);
+    // Ring buffer: a power of two of at least half a second of frames,
+    // four bytes each (16 bits * 2 channels).
+
+    for (render_buffer_frames = 1024;
+         render_buffer_frames < (unsigned int) mixing_freq / 2;
+         render_buffer_frames <<= 1);
+
+    render_buffer = malloc(render_buffer_frames * 4);
+
+    if (render_buffer == NULL)
+    {
+        fprintf(stderr, "OPL_SDL: unable to allocate render buffer\n");
+
+        OPL_SDL_Shutdown();
+        return 0;
+    }
+
+    render_ahead_frames = (mixing_freq * RENDER_AHEAD_TIME) / 1000;
+
+    SDL_AtomicSet(&render_write_pos, 0);
+    SDL_AtomicSet(&render_read_pos, 0);
+    SDL_AtomicSet(&render_callback_frames, (int) GetSliceSize());
+    SDL_AtomicSet(&render_quit, 0);
 
     // Create the emulator structure:
 
@@ -354,6 +607,29 @@ static int OPL_SDL_Init(unsigned int port_base)
 
     callback_mutex = SDL_CreateMutex();
     callback_queue_mutex = SDL_CreateMutex();
+    write_queue_mutex = SDL_CreateMutex();
+    render_sem = SDL_CreateSemaphore(0);
+
+    // Offline, the caller renders and its register writes apply at once.
+
+    if (render_offline)
+    {
+        render_thread_id = SDL_ThreadID();
+        return 1;
+    }
+
+    render_thread = SDL_CreateThread(RenderThread, "OPL render", NULL);
+
+    if (render_thread == NULL)
+    {
+        fprintf(stderr, "OPL_SDL: unable to start render thread: %s\n",
+                SDL_GetError());
+
+        OPL_SDL_Shutdown();
+        return 0;
+    }
+
+    render_thread_id = SDL_GetThreadID(render_thread);
 
     // Set postmix that adds the OPL music. This is deliberately done
     // as a postmix and not using Mix_HookMusic() as the latter disables
@@ -402,6 +678,24 @@ static void OPLTimer_CalculateEndTime(opl_timer_t *timer)
     }
 }
 
+static void QueueWrite(unsigned int reg_num, unsigned int value)
+{
+    SDL_LockMutex(write_queue_mutex);
+
+    if (write_queue_len == write_queue_size)
+    {
+        write_queue_size = write_queue_size ? write_queue_size * 2 : 256;
+        write_queue = realloc(write_queue,
+                              write_queue_size * sizeof(*write_queue));
+    }
+
+    write_queue[write_queue_len].reg = reg_num;
+    write_queue[write_queue_len].value = value;
+    ++write_queue_len;
+
+    SDL_UnlockMutex(write_queue_mutex);
+}
+
 static void WriteRegister(unsigned int reg_num, unsigned int value)
 {
     switch (reg_num)
@@ -443,7 +737,16 @@ static void WriteRegister(unsigned int reg_num, unsigned int value)
             opl_opl3mode = value & 0x01;
 
         default:
-            OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            // Writes made by callbacks come from the render thread and
+            // take effect right away; others wait until it gets to them.
+            if (SDL_ThreadID() == render_thread_id)
+            {
+                OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            }
+            else
+            {
+                QueueWrite(reg_num, value);
+            }
             break;
     }
 }
@@ -515,6 +818,7 @@ opl_driver_t opl_sdl_driver =
     OPL_SDL_Unlock,
     OPL_SDL_SetPaused,
     OPL_SDL_AdjustCallbacks,
+    OPL_SDL_Render,
 };
 
 
@@ -80,6 +80,11 @@ int CRL_buttons_counter;
 // FPS counter.
 int CRL_fps;
 
+// Frame pacing: average, jitter and worst frame interval, in microseconds.
+int CRL_frametime;
+int CRL_frametime_jitter;
+int CRL_frametime_worst;
+
 // [JN] Imitate jump by Arch-Vile's attack.
 // Do not modify buttoncode_t (d_event.h) for consistency.
 boolean CRL_vilebomb = false;
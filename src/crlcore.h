@@ -225,6 +225,9 @@ extern int  CRL_buttons_counter;
 
 extern void CRL_DrawFPS (void);
 extern int  CRL_fps;
+extern int  CRL_frametime;
+extern int  CRL_frametime_jitter;
+extern int  CRL_frametime_worst;
 
 extern boolean CRL_vilebomb;
 extern boolean CRL_aircontrol;
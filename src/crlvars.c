@@ -29,6 +29,7 @@
 char *screenshots_format = "png";     // "png" or "jpg"
 int screenshots_png_compression = 6;  // 0 ... 10
 int screenshots_jpg_quality = 90;     // 1 ... 100
+int screenshots_native = 0;           // 320x200 game pixels
 
 // Compatibility
 int vanilla_savegame_limit = 1;
@@ -75,6 +76,7 @@ int crl_widget_coordsfrac = 0;
 int crl_widget_speed = 0;
 int crl_widget_powerups = 0;
 int crl_widget_health = 0;
+int crl_widget_thinkers = 0;
 
 // Sound
 int crl_monosfx = 0;
@@ -130,6 +132,9 @@ int crl_vanilla_limits = 1;
 // Mouse look
 int crl_mouselook = 0;
 
+// Performance
+int crl_sight_cache = 0;  // 0 = off, 1 = on, 2 = on with verification
+
 // -----------------------------------------------------------------------------
 // [JN] CRL-specific config variables binding function.
 // -----------------------------------------------------------------------------
@@ -143,6 +148,7 @@ void CRL_BindVariables (void)
     M_BindStringVariable("screenshots_format",          &screenshots_format);
     M_BindIntVariable("screenshots_png_compression",    &screenshots_png_compression);
     M_BindIntVariable("screenshots_jpg_quality",        &screenshots_jpg_quality);
+    M_BindIntVariable("screenshots_native",             &screenshots_native);
 
     // Compatibility
     M_BindIntVariable("vanilla_savegame_limit",         &vanilla_savegame_limit);
@@ -187,6 +193,7 @@ void CRL_BindVariables (void)
     M_BindIntVariable("crl_widget_speed",               &crl_widget_speed);
     M_BindIntVariable("crl_widget_powerups",            &crl_widget_powerups);
     M_BindIntVariable("crl_widget_health",              &crl_widget_health);
+    M_BindIntVariable("crl_widget_thinkers",            &crl_widget_thinkers);
 
     // Sound
     M_BindIntVariable("crl_monosfx",                    &crl_monosfx);
@@ -241,4 +248,7 @@ void CRL_BindVariables (void)
 
     // Mouse look
     M_BindIntVariable("crl_mouselook",                  &crl_mouselook);
+
+    // Performance
+    M_BindIntVariable("crl_sight_cache",                &crl_sight_cache);
 }
@@ -29,6 +29,7 @@
 extern char *screenshots_format;
 extern int screenshots_png_compression;
 extern int screenshots_jpg_quality;
+extern int screenshots_native;
 
 // Compatibility
 extern int vanilla_savegame_limit;
@@ -75,6 +76,7 @@ extern int crl_widget_coordsfrac;
 extern int crl_widget_speed;
 extern int crl_widget_powerups;
 extern int crl_widget_health;
+extern int crl_widget_thinkers;
 
 // Sound
 extern int crl_monosfx;
@@ -130,4 +132,7 @@ extern int crl_vanilla_limits;
 // Mouse look
 extern int crl_mouselook;
 
+// Performance
+extern int crl_sight_cache;
+
 extern void CRL_BindVariables (void);
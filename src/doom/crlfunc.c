@@ -782,19 +782,35 @@ void CRL_StatDrawer (void)
 //  in case of custom font is thinner or thicker.
 // -----------------------------------------------------------------------------
 
-void CRL_DrawFPS (void)
+static int CRL_FPSTopRow (void)
 {
-    char fps[8];
-    char fps_str[4];
-    int yy = 9;
-
     // [JN] If demo timer is active and running, shift FPS widget one line down.
     if ((demoplayback && (crl_demo_timer == 1 || crl_demo_timer == 3))
     ||  (demorecording && (crl_demo_timer == 2 || crl_demo_timer == 3)))
     {
-        yy += 9;
+        return 18;
+    }
+
+    return 9;
+}
+
+// [JN] Last row drawn by CRL_DrawFPS, or 0 if it is not drawn.
+static int CRL_FPSBottomRow (void)
+{
+    if (!crl_showfps || gamestate == GS_FINALE)
+    {
+        return 0;
     }
 
+    return CRL_FPSTopRow() + (crl_showfps == 2 ? 18 : 0);
+}
+
+void CRL_DrawFPS (void)
+{
+    char fps[8];
+    char fps_str[4];
+    int yy = CRL_FPSTopRow();
+
     sprintf(fps, "%d", CRL_fps);
     sprintf(fps_str, "FPS");
 
@@ -802,6 +818,26 @@ void CRL_DrawFPS (void)
                                  - M_StringWidth(fps_str), yy, fps, cr[CR_GRAY]);
 
     M_WriteText(SCREENWIDTH - 7 - M_StringWidth(fps_str), yy, "FPS", cr[CR_GRAY]);
+
+    // [JN] Frame pacing: average frame time and its jitter, milliseconds.
+    if (crl_showfps == 2)
+    {
+        char ms[16];
+
+        yy += 9;
+        sprintf(ms, "%.2f", CRL_frametime / 1000.0);
+        M_WriteText(SCREENWIDTH - 11 - M_StringWidth(ms)
+                                     - M_StringWidth("MS"), yy, ms, cr[CR_GRAY]);
+        M_WriteText(SCREENWIDTH - 7 - M_StringWidth("MS"), yy, "MS", cr[CR_GRAY]);
+
+        yy += 9;
+        sprintf(ms, "%.2f", CRL_frametime_jitter / 1000.0);
+        M_WriteText(SCREENWIDTH - 11 - M_StringWidth(ms)
+                                     - M_StringWidth("JIT"), yy, ms,
+                    CRL_frametime_worst > 2 * CRL_frametime ?
+                    cr[CR_YELLOW] : cr[CR_GRAY]);
+        M_WriteText(SCREENWIDTH - 7 - M_StringWidth("JIT"), yy, "JIT", cr[CR_GRAY]);
+    }
 }
 
 // =============================================================================
@@ -957,3 +993,82 @@ void CRL_DrawPlayerSpeed (void)
 
     dp_translucent = false;
 }
+
+// -----------------------------------------------------------------------------
+// CRL_DrawThinkerProfiler
+//  [JN] Draws time spent per game tic by thinkers, bucketed per thinker
+//  function, plus the most expensive mobj type. Values are averaged
+//  over the last second and updated once per second by P_RunThinkers.
+// -----------------------------------------------------------------------------
+
+void CRL_DrawThinkerProfiler (void)
+{
+    char str[32];
+    const double freq = (double)I_GetPerfFrequency();
+    uint64_t total = 0;
+    int heavy = -1;
+    int yy = 36;
+    int i;
+
+    // [JN] Keep a blank line below the FPS widget, however tall it is.
+    if (yy < CRL_FPSBottomRow() + 18)
+    {
+        yy = CRL_FPSBottomRow() + 18;
+    }
+
+    if (!thinkerprof_tics)
+    {
+        return;  // Nothing measured yet.
+    }
+
+    // Apply translucency while Save/Load menu is active.
+    dp_translucent = savemenuactive;
+
+    for (i = 0 ; i < NUMTHINKERPROFS ; i++)
+    {
+        total += thinkerprof[i].time;
+    }
+
+    M_snprintf(str, sizeof(str), "%.2f MS", total * 1000.0 / freq / thinkerprof_tics);
+    M_WriteText(SCREENWIDTH - 7 - M_StringWidth(str), yy, str, cr[CR_GREEN]);
+    M_WriteText(SCREENWIDTH - 11 - M_StringWidth(str) - M_StringWidth("THK:"),
+                yy, "THK:", cr[CR_GRAY]);
+
+    for (i = 0 ; i < NUMTHINKERPROFS ; i++)
+    {
+        if (!thinkerprof[i].calls)
+        {
+            continue;
+        }
+
+        yy += 9;
+        M_snprintf(str, sizeof(str), "%.2f/%d",
+                   thinkerprof[i].time * 1000.0 / freq / thinkerprof_tics,
+                   thinkerprof[i].calls / thinkerprof_tics);
+        M_WriteText(SCREENWIDTH - 7 - M_StringWidth(str), yy, str, cr[CR_GREEN]);
+        M_WriteText(SCREENWIDTH - 11 - M_StringWidth(str) - M_StringWidth(thinkerprof_names[i]),
+                    yy, thinkerprof_names[i], cr[CR_GRAY]);
+    }
+
+    // Most expensive mobj type, shown by its editor number.
+    for (i = 0 ; i < NUMMOBJTYPES ; i++)
+    {
+        if (thinkerprof_mobj[i].calls
+        && (heavy < 0 || thinkerprof_mobj[i].time > thinkerprof_mobj[heavy].time))
+        {
+            heavy = i;
+        }
+    }
+
+    if (heavy >= 0)
+    {
+        yy += 9;
+        M_snprintf(str, sizeof(str), "#%d %.2f", mobjinfo[heavy].doomednum,
+                   thinkerprof_mobj[heavy].time * 1000.0 / freq / thinkerprof_tics);
+        M_WriteText(SCREENWIDTH - 7 - M_StringWidth(str), yy, str, cr[CR_YELLOW]);
+        M_WriteText(SCREENWIDTH - 11 - M_StringWidth(str) - M_StringWidth("TOP:"),
+                    yy, "TOP:", cr[CR_GRAY]);
+    }
+
+    dp_translucent = false;
+}
@@ -35,6 +35,7 @@ extern int  defdemotics, deftotaldemotics;
 
 extern void CRL_DrawTargetsHealth (void);
 extern void CRL_DrawPlayerSpeed (void);
+extern void CRL_DrawThinkerProfiler (void);
 
 // Power-up counters:
 extern int CRL_invul_counter;
@@ -66,6 +66,9 @@
 #include "i_system.h"
 
 #include "g_game.h"
+#include "g_demoseek.h"
+#include "g_stress.h"
+#include "g_verify.h"
 
 #include "wi_stuff.h"
 #include "st_bar.h"
@@ -360,6 +363,10 @@ static void D_Display (void)
                     // [PN] Player speed widget.
                     if (crl_widget_speed)
                     CRL_DrawPlayerSpeed();
+
+                    // [JN] Thinker profiler widget.
+                    if (crl_widget_thinkers)
+                    CRL_DrawThinkerProfiler();
                 }
 
                 // [JN] Main status bar drawing function.
@@ -647,6 +654,8 @@ void D_DoomLoop (void)
 		}
 
 		S_UpdateSounds (players[displayplayer].mo);// move positional sounds
+		// [JN] Mix the audio of these tics, if there is no audio device.
+		I_UpdateSoundSink(gametic - oldgametic);
 		oldgametic = gametic;
 	}
     }
@@ -1402,7 +1411,8 @@ static void D_Endoom(void)
     // game has actually started.
 
     if (!show_endoom || !main_loop_started
-     || screensaver_mode || M_CheckParm("-testcontrols") > 0)
+     || screensaver_mode || M_CheckParm("-testcontrols") > 0
+     || M_CheckParm("-demostate") > 0)
     {
         return;
     }
@@ -1772,8 +1782,46 @@ void D_DoomMain (void)
     }
 #endif
 
+    //!
+    // @arg <file>
+    // @category demo
+    //
+    // Play every demo listed in the given file (one path per line) in
+    // parallel worker processes without graphics or sound, and check
+    // the state each one ends in against -verifyexpect. Exits with an
+    // error if any demo fails or mismatches.
+    //
+
+    p = M_CheckParmWithArgs("-verifydemos", 1);
+
+    if (p)
+    {
+        int jobs = 0;
+
+        //!
+        // @arg <n>
+        // @category demo
+        //
+        // Number of worker processes for -verifydemos. Defaults to the
+        // number of CPU cores.
+        //
+
+        int j = M_CheckParmWithArgs("-verifyjobs", 1);
+
+        if (j)
+        {
+            jobs = atoi(myargv[j+1]);
+        }
+
+        G_VerifyDemos(myargv[p+1], jobs);
+    }
+
     // Save configuration at exit.
-    I_AtExit(M_SaveDefaults, true); // [crispy] always save configuration at exit
+    // [JN] Not in -verifydemos workers, many of which run at once.
+    if (!M_CheckParm("-demostate"))
+    {
+        I_AtExit(M_SaveDefaults, true); // [crispy] always save configuration at exit
+    }
 
     // Find main IWAD file and load it.
     iwadfile = D_FindIWAD(IWAD_MASK_DOOM, &gamemission);
@@ -2128,6 +2176,27 @@ void D_DoomMain (void)
     I_CheckIsScreensaver();
     I_InitTimer();
     I_InitJoystick();
+
+    //!
+    // @arg <dir>
+    // @category obscure
+    //
+    // Render every music lump to WAV files in the given directory,
+    // through the OPL emulator and FluidSynth (if available), report
+    // how fast each song was synthesised compared to real time, and
+    // exit. The OPL emulator renders through both its SIMD and scalar
+    // envelope paths, and the exit status is an error if they differ.
+    //
+
+    p = M_CheckParmWithArgs("-rendermusic", 1);
+
+    if (p)
+    {
+        I_RenderMusic(myargv[p+1]);
+        exit(0);
+    }
+
+    I_EnableSoundSink();
     I_InitSound(doom);
     I_InitMusic();
 
@@ -2323,6 +2392,21 @@ void D_DoomMain (void)
         DEH_printf("External statistics registered.\n");
     }
 
+    //!
+    // @arg <filename>
+    // @category obscure
+    //
+    // Profile the time spent by thinkers and write per-level results
+    // to the specified file every time a level is completed.
+    //
+
+    p = M_CheckParmWithArgs("-thinkerdump", 1);
+
+    if (p)
+    {
+        thinkerdump_file = myargv[p+1];
+    }
+
     //!
     // @arg <x>
     // @category demo
@@ -2339,11 +2423,105 @@ void D_DoomMain (void)
 	autostart = true;
     }
 
+    //!
+    // @arg <tics>
+    // @category obscure
+    //
+    // Run a headless load test: load the map chosen with -warp, run
+    // the given number of tics without graphics and print playsim
+    // throughput, peak thinkers, zone memory and render counters.
+    //
+
+    p = M_CheckParmWithArgs("-stress", 1);
+
+    if (p)
+    {
+        int stresstics = atoi(myargv[p+1]);
+        int stressmobjs = 0;
+        int stresstypes[16];
+        int numstresstypes = 0;
+        int stresssave = 0;
+
+        //!
+        // @arg <n>
+        // @category obscure
+        //
+        // Spawn n extra monsters around the player start for -stress.
+        //
+
+        p = M_CheckParmWithArgs("-stressmobjs", 1);
+
+        if (p)
+        {
+            stressmobjs = atoi(myargv[p+1]);
+        }
+
+        //!
+        // @arg <type> [<type> ...]
+        // @category obscure
+        //
+        // Thing types (editor numbers) spawned by -stressmobjs, used in
+        // turn. Former Human (3004) by default.
+        //
+
+        p = M_CheckParmWithArgs("-stresstype", 1);
+
+        if (p)
+        {
+            while (++p != myargc && myargv[p][0] != '-'
+            && numstresstypes < (int) arrlen(stresstypes))
+            {
+                stresstypes[numstresstypes++] = atoi(myargv[p]);
+            }
+        }
+
+        //!
+        // @arg <n>
+        // @category obscure
+        //
+        // After -stress, time n rounds of archiving and restoring all
+        // map objects through the in-memory savegame stream.
+        //
+
+        p = M_CheckParmWithArgs("-stresssave", 1);
+
+        if (p)
+        {
+            stresssave = atoi(myargv[p+1]);
+        }
+
+        G_StressTest(stresstics, stressmobjs, stresstypes, numstresstypes,
+                     stresssave);
+    }
+
+    //!
+    // @arg <tic>
+    // @category demo
+    //
+    // Jump to the given tic (35 per second) once demo playback
+    // started with -playdemo begins.
+    //
+
+    p = M_CheckParmWithArgs("-demoseek", 1);
+
+    if (p)
+    {
+        G_DemoSeekOnStart(atoi(myargv[p+1]));
+    }
+
     p = M_CheckParmWithArgs("-playdemo", 1);
     if (p)
     {
 	singledemo = true;              // quit after one demo
 	G_DeferedPlayDemo (demolumpname);
+
+        // [JN] -verifydemos workers play as fast as possible, unseen.
+        if (M_CheckParm("-demostate"))
+        {
+            nodrawers = true;
+            singletics = true;
+        }
+
 	D_DoomLoop ();  // never returns
     }
     demowarp = 0; // [crispy] we don't play a demo, so don't skip maps
@@ -72,7 +72,8 @@ typedef enum
     ga_victory,
     ga_worlddone,
     ga_screenshot,
-    ga_rewind
+    ga_rewind,
+    ga_demoseek
 } gameaction_t;
 
 
@@ -271,6 +271,7 @@ extern int		skyflatnum;
 
 
 extern	int		rndindex;
+extern	int		prndindex;
 
 extern  ticcmd_t       *netcmds;
 
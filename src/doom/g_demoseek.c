@@ -0,0 +1,373 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//  Demo seek index. While a demo plays, full game state snapshots are
+//  taken at regular intervals of demo time, using the rewind keyframe
+//  machinery. Playback can then jump to any tic by restoring the
+//  nearest earlier snapshot and fast forwarding through at most one
+//  interval.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "doomstat.h"
+#include "d_loop.h"
+#include "d_main.h"
+#include "g_demoseek.h"
+#include "g_game.h"
+#include "g_rewind.h"
+#include "i_timer.h"
+#include "m_misc.h"
+#include "p_local.h"
+#include "s_sound.h"
+#include "st_bar.h"
+
+#include "crlcore.h"
+#include "crlfunc.h"
+
+
+// Snapshot spacing at the start of playback, in demo tics.
+#define DEMOSEEK_INTERVAL  (10 * TICRATE)
+
+// Snapshots kept at most. When the index is full, every other one is
+// dropped and the spacing doubles, so multi-hour demos stay bounded.
+#define DEMOSEEK_MAXSNAPSHOTS  256
+
+typedef struct
+{
+    int     tic;            // defdemotics when taken
+    size_t  demopos;        // demo_p - demobuffer
+    int     prndindex;
+    int     rndindex;
+    int     tracerphase;    // gametic + 1 - demostarttic
+    int     numbraintargets;
+    int     braintargeton;
+    byte   *data;
+    size_t  size;
+} demosnapshot_t;
+
+static demosnapshot_t snapshots[DEMOSEEK_MAXSNAPSHOTS];
+static int numsnapshots;
+static int interval = DEMOSEEK_INTERVAL;
+
+// Tic requested by G_DemoSeek, handled by G_DoDemoSeek.
+static int pendingtic;
+
+// Tic to stop fast forwarding at, -1 if not seeking.
+static int seektarget = -1;
+
+// Seek requested with -demoseek, applied when playback starts.
+static int starttic;
+
+
+static void G_DemoSeekFree (void)
+{
+    int i;
+
+    for (i = 0 ; i < numsnapshots ; i++)
+    {
+        free(snapshots[i].data);
+    }
+
+    numsnapshots = 0;
+    interval = DEMOSEEK_INTERVAL;
+}
+
+static void G_DemoSeekEndFastForward (void)
+{
+    if (seektarget >= 0)
+    {
+        seektarget = -1;
+        G_DemoGoToNextLevel(false);
+    }
+}
+
+//
+// G_DemoSeekThin
+//  Drops every other snapshot and doubles the spacing. The first one,
+//  taken on the first tic, is always kept.
+//
+
+static void G_DemoSeekThin (void)
+{
+    int i, j;
+
+    for (i = 0, j = 0 ; i < numsnapshots ; i++)
+    {
+        if (i & 1)
+        {
+            free(snapshots[i].data);
+        }
+        else
+        {
+            snapshots[j++] = snapshots[i];
+        }
+    }
+
+    numsnapshots = j;
+    interval *= 2;
+}
+
+static void G_DemoSeekSnapshot (void)
+{
+    demosnapshot_t *const snap = &snapshots[numsnapshots];
+
+    if (!G_RewindCaptureState(&snap->data, &snap->size))
+    {
+        return;
+    }
+
+    snap->tic = defdemotics;
+    snap->demopos = demo_p - demobuffer;
+    snap->prndindex = prndindex;
+    snap->rndindex = rndindex;
+    snap->tracerphase = gametic + 1 - demostarttic;
+    snap->numbraintargets = numbraintargets;
+    snap->braintargeton = braintargeton;
+
+    numsnapshots++;
+}
+
+//
+// G_DemoSeekBrainTargets
+//  A_BrainAwake collected the spawn spots in thinker order, but the
+//  restored map objects are new ones, so collect them again.
+//
+
+static void G_DemoSeekBrainTargets (void)
+{
+    thinker_t *th;
+    int count = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap && count < numbraintargets ;
+         th = th->next)
+    {
+        if (th->function.acp1 == (actionf_p1) P_MobjThinker
+        &&  ((mobj_t *) th)->type == MT_BOSSTARGET)
+        {
+            braintargets[count++] = (mobj_t *) th;
+        }
+    }
+}
+
+static boolean G_DemoSeekRestore (const demosnapshot_t *snap)
+{
+    const int spyplayer = displayplayer;
+
+    if (!G_RewindRestoreState(snap->data, snap->size))
+    {
+        return false;
+    }
+
+    // Restoring goes through G_InitNew, which leaves demo playback.
+    demoplayback = true;
+    usergame = false;
+
+    demo_p = demobuffer + snap->demopos;
+    defdemotics = snap->tic;
+    prndindex = snap->prndindex;
+    rndindex = snap->rndindex;
+    demostarttic = gametic - snap->tracerphase;
+    braintargeton = snap->braintargeton;
+    numbraintargets = snap->numbraintargets;
+
+    // Keep looking through the eyes of the player chosen with spy mode.
+    displayplayer = spyplayer;
+
+    if (numbraintargets > 0 && braintargets != NULL)
+    {
+        G_DemoSeekBrainTargets();
+    }
+
+    st_fullupdate = true;
+
+    return true;
+}
+
+//
+// G_DemoSeekStart
+//  Called when demo playback begins.
+//
+
+void G_DemoSeekStart (void)
+{
+    G_DemoSeekEndFastForward();
+    G_DemoSeekFree();
+
+    if (starttic > 0)
+    {
+        G_DemoSeek(starttic);
+        starttic = 0;
+    }
+}
+
+//
+// G_DemoSeekStop
+//  Called when demo playback ends.
+//
+
+void G_DemoSeekStop (void)
+{
+    G_DemoSeekEndFastForward();
+    G_DemoSeekFree();
+}
+
+//
+// G_DemoSeekTicker
+//  Called at the end of every game tic. Ends fast forwarding once the
+//  target is reached and takes snapshots of newly played demo time.
+//
+
+void G_DemoSeekTicker (void)
+{
+    int i;
+
+    if (!demoplayback)
+    {
+        return;
+    }
+
+    if (seektarget >= 0 && defdemotics >= seektarget)
+    {
+        G_DemoSeekEndFastForward();
+    }
+
+    // Only levels are indexed. A pending game action or player reborn
+    // would be lost when restoring, so such tics are skipped too.
+    if (gamestate != GS_LEVEL || gameaction != ga_nothing)
+    {
+        return;
+    }
+
+    for (i = 0 ; i < MAXPLAYERS ; i++)
+    {
+        if (playeringame[i] && players[i].playerstate == PST_REBORN)
+        {
+            return;
+        }
+    }
+
+    // Already indexed (playing again after seeking back) or paused.
+    if (numsnapshots > 0 && defdemotics <= snapshots[numsnapshots - 1].tic)
+    {
+        return;
+    }
+
+    if (numsnapshots > 0 && defdemotics % interval != 0)
+    {
+        return;
+    }
+
+    if (numsnapshots == DEMOSEEK_MAXSNAPSHOTS)
+    {
+        G_DemoSeekThin();
+
+        if (defdemotics % interval != 0)
+        {
+            return;
+        }
+    }
+
+    G_DemoSeekSnapshot();
+}
+
+//
+// G_DemoSeek
+//  Requests a jump to the given demo tic.
+//
+
+void G_DemoSeek (int tic)
+{
+    if (!demoplayback)
+    {
+        return;
+    }
+
+    pendingtic = BETWEEN(0, deftotaldemotics, tic);
+    gameaction = ga_demoseek;
+}
+
+void G_DemoSeekBy (int seconds)
+{
+    const int from = seektarget >= 0 ? seektarget : defdemotics;
+    static char msg[32];
+
+    G_DemoSeek(from + seconds * TICRATE);
+
+    M_snprintf(msg, sizeof(msg), "DEMO TIME %d:%02d",
+               pendingtic / TICRATE / 60, pendingtic / TICRATE % 60);
+    CRL_SetMessage(&players[consoleplayer], msg, false, NULL);
+}
+
+//
+// G_DoDemoSeek
+//  Restores the nearest snapshot at or before the requested tic, if it
+//  is closer than the current position, and fast forwards from there.
+//
+
+void G_DoDemoSeek (void)
+{
+    const int target = pendingtic;
+    int best = -1;
+    int i;
+
+    gameaction = ga_nothing;
+
+    if (!demoplayback)
+    {
+        return;
+    }
+
+    for (i = numsnapshots - 1 ; i >= 0 ; i--)
+    {
+        if (snapshots[i].tic <= target)
+        {
+            best = i;
+            break;
+        }
+    }
+
+    // Before the first snapshot, the first tic is as close as it gets.
+    if (best < 0 && numsnapshots > 0 && target < defdemotics)
+    {
+        best = 0;
+    }
+
+    if (best >= 0
+    && (target < defdemotics || snapshots[best].tic > defdemotics))
+    {
+        G_DemoSeekRestore(&snapshots[best]);
+    }
+
+    if (target > defdemotics)
+    {
+        seektarget = target;
+        G_DemoGoToNextLevel(true);
+    }
+    else
+    {
+        G_DemoSeekEndFastForward();
+    }
+}
+
+//
+// G_DemoSeekOnStart
+//  Seek to the given tic once the next demo starts playing.
+//
+
+void G_DemoSeekOnStart (int tic)
+{
+    starttic = tic;
+}
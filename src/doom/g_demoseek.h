@@ -0,0 +1,23 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+#pragma once
+
+void G_DemoSeekStart(void);
+void G_DemoSeekStop(void);
+void G_DemoSeekTicker(void);
+void G_DemoSeek(int tic);
+void G_DemoSeekBy(int seconds);
+void G_DoDemoSeek(void);
+void G_DemoSeekOnStart(int tic);
@@ -33,6 +33,7 @@
 #include "z_zone.h"
 #include "f_finale.h"
 #include "m_argv.h"
+#include "m_asyncwrite.h"
 #include "m_controls.h"
 #include "m_misc.h"
 #include "m_menu.h"
@@ -57,7 +58,9 @@
 #include "w_wad.h"
 
 #include "p_local.h" 
+#include "g_demoseek.h"
 #include "g_rewind.h"
+#include "g_verify.h"
 
 #include "s_sound.h"
 
@@ -1233,6 +1236,15 @@ boolean G_Responder (event_t* ev)
 	return true; 
     }
     
+    // [JN] Demo seek: the rewind key steps back through -playdemo
+    // playback, or forward while the run key is held.
+    if (demoplayback && singledemo && ev->type == ev_keydown
+    && (ev->data1 == key_crl_rewind || ev->data1 == key_crl_rewind2))
+    {
+        G_DemoSeekBy(speedkeydown() ? 10 : -10);
+        return true;
+    }
+
     // any other key pops up menu if in demos
     if (gameaction == ga_nothing && !singledemo && 
 	(demoplayback || gamestate == GS_DEMOSCREEN) 
@@ -1573,6 +1585,31 @@ static void G_ReadGameParms (void)
     nomonsters = M_CheckParm ("-nomonsters");
 }
  
+//
+// G_CheckSaveWriter
+//  [JN] Reports the result of a savegame written in the background.
+//
+
+static void G_CheckSaveWriter (void)
+{
+    switch (M_AsyncWritePoll())
+    {
+        case ASYNCWRITE_DONE:
+            CRL_SetMessage(&players[consoleplayer], DEH_String(GGSAVED),
+                           false, NULL);
+            break;
+
+        case ASYNCWRITE_FAILED:
+            CRL_SetMessageCritical("G_DoSaveGame:",
+                                   "Failed to write savegame file",
+                                   MESSAGETICS);
+            break;
+
+        default:
+            break;
+    }
+}
+
 //
 // G_Ticker
 // Make ticcmd_ts for the players.
@@ -1583,6 +1620,9 @@ void G_Ticker (void)
     int		buf; 
     ticcmd_t*	cmd;
     
+    // [JN] Report background savegame writes.
+    G_CheckSaveWriter();
+
     // do player reborns if needed
     for (i=0 ; i<MAXPLAYERS ; i++) 
 	if (playeringame[i] && players[i].playerstate == PST_REBORN) 
@@ -1632,6 +1672,9 @@ void G_Ticker (void)
 	  case ga_rewind:
 	    G_LoadAutoKeyframe();
 	    break;
+	  case ga_demoseek:
+	    G_DoDemoSeek();
+	    break;
 	  case ga_nothing: 
 	    break; 
 	} 
@@ -1809,6 +1852,12 @@ void G_Ticker (void)
 	break;
     }        
 
+    // [JN] Index demo playback for seeking.
+    G_DemoSeekTicker();
+
+    // [JN] Record or check demo state hashes.
+    G_VerifyTicker();
+
     // [JN] Reduce message tics independently from framerate and game states.
     // Tics can't go negative.
     MSG_Ticker();
@@ -2462,6 +2511,12 @@ void G_DoCompleted (void)
     automapactive = false; 
 
     StatCopy(&wminfo);
+
+    // [JN] Write thinker profiler results of completed level.
+    P_DumpThinkerProfiler();
+
+    // [JN] Read in the next level's music while the intermission plays.
+    S_PrefetchLevelMusic(wminfo.epsd + 1, wminfo.next + 1);
  
     WI_Start (&wminfo); 
 } 
@@ -2539,6 +2594,9 @@ void G_DoLoadGame (void)
     }
     gameaction = ga_nothing; 
 	 
+    // [JN] The savegame may still be on its way to disk.
+    M_AsyncWriteWait();
+
     save_stream = M_fopen(savename, "rb");
 
     if (save_stream == NULL)
@@ -2627,33 +2685,24 @@ void G_DoSaveGame (void)
 
     char *savegame_file;
     char *temp_savegame_file;
-    char *recovery_savegame_file;
+    byte *data;
+    size_t len;
 
-    recovery_savegame_file = NULL;
     temp_savegame_file = P_TempSaveGameFile();
     savegame_file = P_SaveGameFile(savegameslot);
 
-    // Open the savegame file for writing.  We write to a temporary file
-    // and then rename it at the end if it was successfully written.
-    // This prevents an existing savegame from being overwritten by
-    // a corrupted one, or if a savegame buffer overrun occurs.
-    save_stream = M_fopen(temp_savegame_file, "wb");
+    // [JN] Serialize into memory and let a writer thread put it on disk.
+    // It writes to a temporary file and renames it at the end if it was
+    // successfully written. This prevents an existing savegame from being
+    // overwritten by a corrupted one, or if a savegame buffer overrun occurs.
+    // The result is reported by G_CheckSaveWriter.
+    P_OpenMemorySaveFile();
 
-    if (save_stream == NULL)
+    if (savegame_error)
     {
-        // Failed to save the game, so we're going to have to abort. But
-        // to be nice, save to somewhere else before we call I_Error().
-        recovery_savegame_file = M_TempFile("recovery.dsg");
-        save_stream = M_fopen(recovery_savegame_file, "wb");
-        if (save_stream == NULL)
-        {
-            I_Error("Failed to open either '%s' or '%s' to write savegame.",
-                    temp_savegame_file, recovery_savegame_file);
-        }
+        I_Error("Failed to allocate memory to write savegame.");
     }
 
-    savegame_error = false;
-
     P_WriteSaveGameHeader(savedescription);
 
     P_ArchivePlayers ();
@@ -2666,7 +2715,7 @@ void G_DoSaveGame (void)
     // Enforce the same savegame size limit as in Vanilla Doom,
     // except if the vanilla_savegame_limit setting is turned off.
 
-    if (vanilla_savegame_limit && ftell(save_stream) > SAVEGAMESIZE)
+    if (vanilla_savegame_limit && P_SaveGameTell() > SAVEGAMESIZE)
     {
         char *message = "Savegame overflow (vanilla crashes here)";
 
@@ -2690,32 +2739,23 @@ void G_DoSaveGame (void)
     // [PN] Write savegame preview thumbnail after optional tail blocks.
     P_ArchiveSavePreview();
 
-    // Finish up, close the savegame file.
+    // Finish up, hand the savegame over to the writer.
 
-    fclose(save_stream);
-
-    if (recovery_savegame_file != NULL)
+    if (!P_CloseMemorySaveGame(&data, &len))
     {
-        // We failed to save to the normal location, but we wrote a
-        // recovery file to the temp directory. Now we can bomb out
-        // with an error.
-        I_Error("Failed to open savegame file '%s' for writing.\n"
-                "But your game has been saved to '%s' for recovery.",
-                temp_savegame_file, recovery_savegame_file);
+        I_Error("Failed to write savegame.");
     }
 
-    // Now rename the temporary savegame file to the actual savegame
-    // file, overwriting the old savegame if there was one there.
-
-    M_remove(savegame_file);
-    M_rename(temp_savegame_file, savegame_file);
+    if (!M_AsyncWriteFile(temp_savegame_file, savegame_file, data, len))
+    {
+        CRL_SetMessageCritical("G_DoSaveGame:",
+                               "Failed to write savegame file", MESSAGETICS);
+    }
 
     gameaction = ga_nothing;
     M_StringCopy(savedescription, "", sizeof(savedescription));
     M_StringCopy(savename, savegame_file, sizeof(savename));
 
-    CRL_SetMessage(&players[consoleplayer], DEH_String(GGSAVED), false, NULL);
-
     // draw the pattern into the back screen
     R_FillBackScreen ();
 }
@@ -3201,6 +3241,9 @@ void G_BeginRecording (void)
 	 
     for (i=0 ; i<MAXPLAYERS ; i++) 
 	*demo_p++ = playeringame[i]; 		 
+
+    // [JN] Start collecting state hashes for the demo footer.
+    G_VerifyRecordStart();
 } 
  
 
@@ -3413,7 +3456,14 @@ void G_DoPlayDemo (void)
 	    demo_ptr += numplayersingame * (longtics ? 5 : 4);
 	    deftotaldemotics++;
 	}
+
+	// [JN] Pick up state hashes from the demo footer.
+	G_VerifyPlaybackStart(demo_ptr + 1,
+	                      lumplength - (int) (demo_ptr + 1 - demobuffer));
     }
+
+    // [JN] Start a new demo seek index.
+    G_DemoSeekStart();
 } 
 
 //
@@ -3536,7 +3586,7 @@ static long WriteFileInfo(const char *name, size_t size, long filepos,
 static void G_AddDemoFooter(void)
 {
     byte *data;
-    size_t size;
+    size_t size, hashsize;
     long filepos;
 
     MEMFILE *stream = mem_fopen_write();
@@ -3550,6 +3600,14 @@ static void G_AddDemoFooter(void)
     size = WriteCmdLineLump(stream);
     mem_fputs(DEMO_FOOTER_SEPARATOR, stream);
 
+    // [JN] State hashes for locating desyncs, if recorded.
+    hashsize = G_VerifyWriteDemoHashes(stream);
+    if (hashsize > 0)
+    {
+        mem_fputs(DEMO_FOOTER_SEPARATOR, stream);
+        header.numlumps = LONG(NUM_DEMO_FOOTER_LUMPS + 2);
+    }
+
     header.infotableofs = LONG(mem_ftell(stream));
     mem_fseek(stream, 0, MEM_SEEK_SET);
     mem_fwrite(&header, 1, sizeof(header), stream);
@@ -3559,7 +3617,12 @@ static void G_AddDemoFooter(void)
     filepos = WriteFileInfo("PORTNAME", strlen(PACKAGE_STRING), filepos, stream);
     filepos = WriteFileInfo(NULL, strlen(DEMO_FOOTER_SEPARATOR), filepos, stream);
     filepos = WriteFileInfo("CMDLINE", size, filepos, stream);
-    WriteFileInfo(NULL, strlen(DEMO_FOOTER_SEPARATOR), filepos, stream);
+    filepos = WriteFileInfo(NULL, strlen(DEMO_FOOTER_SEPARATOR), filepos, stream);
+    if (hashsize > 0)
+    {
+        filepos = WriteFileInfo(DEMOHASH_LUMPNAME, hashsize, filepos, stream);
+        WriteFileInfo(NULL, strlen(DEMO_FOOTER_SEPARATOR), filepos, stream);
+    }
 
     mem_get_buf(stream, (void **)&data, &size);
 
@@ -3607,7 +3670,14 @@ boolean G_CheckDemoStatus (void)
 	 
     if (demoplayback) 
     { 
+        // [JN] Report the final state to the -verifydemos runner.
+        if (!demorecording)
+        {
+            G_VerifyWriteState();
+        }
+
         W_ReleaseLumpName(defdemoname);
+        G_DemoSeekStop();
 	demoplayback = false; 
 	netdemo = false;
 	netgame = false;
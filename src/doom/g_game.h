@@ -76,4 +76,6 @@ extern boolean speedkeydown (void);
 // [JN] Fast forward to next level while demo playback.
 extern boolean netdemo; 
 extern boolean demo_gotonextlvl;
+extern byte   *demobuffer;
+extern byte   *demo_p;
 extern void G_DemoGoToNextLevel (boolean start);
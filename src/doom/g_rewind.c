@@ -263,17 +263,11 @@ static keyframe_t *PopKeyframe(void)
     return keyframe;
 }
 
-static keyframe_t *SaveFullKeyframe(void)
-{
-    keyframe_t *const keyframe = calloc(1, sizeof(*keyframe));
-
-    if (keyframe == NULL)
-    {
-        return NULL;
-    }
-
-    keyframe->kind = KEYFRAME_FULL;
+// [JN] Full game state as an in-memory savegame. Shared with the demo
+// seek index, which keeps its own snapshots of the playback.
 
+boolean G_RewindCaptureState(byte **data, size_t *size)
+{
     P_OpenMemorySaveGame();
     P_WriteSaveGameHeader("REWIND");
     P_ArchivePlayers();
@@ -285,7 +279,21 @@ static keyframe_t *SaveFullKeyframe(void)
     P_ArchiveOldSpecials();
     P_ArchiveAutomap();
 
-    if (!P_CloseMemorySaveGame(&keyframe->data, &keyframe->size))
+    return P_CloseMemorySaveGame(data, size);
+}
+
+static keyframe_t *SaveFullKeyframe(void)
+{
+    keyframe_t *const keyframe = calloc(1, sizeof(*keyframe));
+
+    if (keyframe == NULL)
+    {
+        return NULL;
+    }
+
+    keyframe->kind = KEYFRAME_FULL;
+
+    if (!G_RewindCaptureState(&keyframe->data, &keyframe->size))
     {
         FreeKeyframe(keyframe);
         return NULL;
@@ -329,11 +337,11 @@ static keyframe_t *SaveDeltaKeyframe(const int interval_tics)
     return keyframe;
 }
 
-static boolean LoadFullKeyframe(const keyframe_t *keyframe)
+boolean G_RewindRestoreState(const byte *data, size_t size)
 {
     int savedleveltime;
 
-    P_OpenMemoryLoadGame(keyframe->data, keyframe->size);
+    P_OpenMemoryLoadGame((byte *) data, size);
 
     if (!P_ReadSaveGameHeader())
     {
@@ -383,6 +391,11 @@ static boolean LoadFullKeyframe(const keyframe_t *keyframe)
     return true;
 }
 
+static boolean LoadFullKeyframe(const keyframe_t *keyframe)
+{
+    return G_RewindRestoreState(keyframe->data, keyframe->size);
+}
+
 static boolean ReplayDeltaCommands(const ticcmd_t *cmds, const int count)
 {
     int i;
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include "doomtype.h"
 
 void G_Rewind(void);
@@ -21,3 +23,5 @@ void G_SaveAutoKeyframe(void);
 void G_LoadAutoKeyframe(void);
 void G_ResetRewind(boolean force);
 boolean G_RewindIsRestoring(void);
+boolean G_RewindCaptureState(byte **data, size_t *size);
+boolean G_RewindRestoreState(const byte *data, size_t size);
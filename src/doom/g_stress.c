@@ -0,0 +1,467 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//  Headless playsim and renderer load test. Loads a map, optionally
+//  fills it with monsters, runs a fixed number of tics and reports
+//  throughput, thinker count, zone usage and render counters.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomstat.h"
+#include "g_game.h"
+#include "g_stress.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "i_video.h"
+#include "p_local.h"
+#include "r_local.h"
+#include "v_video.h"
+#include "z_zone.h"
+
+#include "crlcore.h"
+
+
+// Distance between spawn spots, in map units.
+#define STRESS_SPACING  64
+
+// Farthest ring of spawn spots tried around the player start.
+#define STRESS_MAXRING  512
+
+// Zone usage is sampled once a second, walking the block list is slow.
+#define STRESS_ZONESAMPLE  TICRATE
+
+
+static int G_StressThinkers (int *mobjs)
+{
+    thinker_t *th;
+    int count = 0;
+
+    *mobjs = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+        if (th->function.acv == (actionf_v)(-1))
+        {
+            continue;
+        }
+        if (th->function.acp1 == (actionf_p1) P_MobjThinker)
+        {
+            (*mobjs)++;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static int G_StressZoneUsed (void)
+{
+    return (int)Z_ZoneSize() - Z_FreeMemory();
+}
+
+static mobjtype_t G_StressTypeForDoomednum (int doomednum)
+{
+    int i;
+
+    for (i = 0 ; i < NUMMOBJTYPES ; i++)
+    {
+        if (mobjinfo[i].doomednum == doomednum)
+        {
+            return i;
+        }
+    }
+
+    I_Error("G_StressTest: unknown thing type %i", doomednum);
+    return MT_PLAYER;
+}
+
+//
+// G_StressReachable
+//  Marks the sectors connected to the given one by two-sided lines,
+//  i.e. those the player can get to, doors and lifts permitting.
+//
+
+static byte *G_StressReachable (const sector_t *start)
+{
+    byte *const reachable = Z_Malloc(numsectors, PU_STATIC, NULL);
+    int *const queue = Z_Malloc(numsectors * sizeof(*queue), PU_STATIC, NULL);
+    int head = 0, tail = 0;
+    int i;
+
+    memset(reachable, 0, numsectors);
+
+    reachable[start - sectors] = 1;
+    queue[tail++] = start - sectors;
+
+    while (head < tail)
+    {
+        const sector_t *const sec = &sectors[queue[head++]];
+
+        for (i = 0 ; i < sec->soundedgecount ; i++)
+        {
+            const int other = sec->soundedges[i].other - sectors;
+
+            if (!reachable[other])
+            {
+                reachable[other] = 1;
+                queue[tail++] = other;
+            }
+        }
+    }
+
+    Z_Free(queue);
+
+    return reachable;
+}
+
+//
+// G_StressInSubsector
+//  True if the point is really inside of the subsector it falls into.
+//  Points in the void between map areas still fall into a subsector,
+//  but behind one of its walls.
+//
+
+static boolean G_StressInSubsector (fixed_t x, fixed_t y,
+                                    const subsector_t *sub)
+{
+    int i;
+
+    for (i = 0 ; i < sub->numlines ; i++)
+    {
+        if (R_PointOnSegSide(x, y, &segs[sub->firstline + i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// G_StressTrySpot
+//  Spawns a monster at the given spot if it fits there
+//  and the player can get to it.
+//
+
+static boolean G_StressTrySpot (fixed_t x, fixed_t y, mobjtype_t type,
+                                const byte *reachable)
+{
+    const int bx = (x - bmaporgx) >> MAPBLOCKSHIFT;
+    const int by = (y - bmaporgy) >> MAPBLOCKSHIFT;
+    const subsector_t *sub;
+    const sector_t *sec;
+    mobj_t *mo;
+
+    // Points outside of the blockmap are outside of the map.
+    if (bx < 0 || bx >= bmapwidth || by < 0 || by >= bmapheight)
+    {
+        return false;
+    }
+
+    sub = R_PointInSubsector(x, y);
+    sec = sub->sector;
+
+    if (!reachable[sec - sectors] || !G_StressInSubsector(x, y, sub))
+    {
+        return false;
+    }
+
+    if (sec->ceilingheight - sec->floorheight < mobjinfo[type].height)
+    {
+        return false;
+    }
+
+    mo = P_SpawnMobj(x, y, ONFLOORZ, type);
+
+    if (!P_CheckPosition(mo, x, y))
+    {
+        P_RemoveMobj(mo);
+        return false;
+    }
+
+    if (mo->flags & MF_COUNTKILL)
+    {
+        totalkills++;
+    }
+
+    return true;
+}
+
+//
+// G_StressSpawn
+//  Places monsters on square rings of a grid around the player,
+//  cycling through the requested types. Returns the number placed.
+//
+
+static int G_StressSpawn (int count, const mobjtype_t *types, int numtypes)
+{
+    const mobj_t *pmo = players[consoleplayer].mo;
+    byte *reachable;
+    int spawned = 0;
+    int ring, i;
+
+    if (pmo == NULL)
+    {
+        return 0;
+    }
+
+    reachable = G_StressReachable(pmo->subsector->sector);
+
+#define TRYSPOT(dx, dy)                                                     \
+    if (spawned < count                                                     \
+    &&  G_StressTrySpot(pmo->x + (dx) * (STRESS_SPACING << FRACBITS),       \
+                        pmo->y + (dy) * (STRESS_SPACING << FRACBITS),       \
+                        types[spawned % numtypes], reachable))              \
+    {                                                                       \
+        spawned++;                                                          \
+    }
+
+    for (ring = 1 ; ring <= STRESS_MAXRING && spawned < count ; ring++)
+    {
+        for (i = -ring ; i <= ring ; i++)
+        {
+            TRYSPOT(i, -ring);
+            TRYSPOT(i, ring);
+        }
+        for (i = -ring + 1 ; i < ring ; i++)
+        {
+            TRYSPOT(-ring, i);
+            TRYSPOT(ring, i);
+        }
+    }
+
+#undef TRYSPOT
+
+    Z_Free(reachable);
+
+    return spawned;
+}
+
+//
+// G_StressRender
+//  Renders one frame from the console player's view into the video
+//  buffer, allocating one if the graphics were never initialized.
+//  Returns the time taken, in performance counter ticks.
+//
+
+static uint64_t G_StressRender (void)
+{
+    uint64_t start;
+
+    if (I_VideoBuffer == NULL)
+    {
+        I_VideoBuffer = Z_Malloc(SCREENWIDTH * SCREENHEIGHT
+                                 * sizeof(*I_VideoBuffer), PU_STATIC, NULL);
+    }
+
+    V_RestoreBuffer();
+    R_ExecuteSetViewSize();
+
+    CRLSurface = I_VideoBuffer;
+
+    start = I_GetPerfCounter();
+    R_RenderPlayerView(&players[consoleplayer]);
+    return I_GetPerfCounter() - start;
+}
+
+//
+// G_StressSaveBench
+//  Times rounds of P_ArchiveThinkers and P_UnArchiveThinkers through
+//  the in-memory savegame stream, as rewind keyframes use it. Leaves
+//  the thinker list rebuilt from the last round, so it has to run
+//  after everything else. Returns the archive size in bytes.
+//
+
+static size_t G_StressSaveBench (int rounds, uint64_t *archive,
+                                 uint64_t *unarchive)
+{
+    byte *data = NULL;
+    size_t len = 0;
+    uint64_t start;
+    int i, j;
+
+    *archive = *unarchive = 0;
+
+    for (i = 0 ; i < rounds ; i++)
+    {
+        free(data);
+
+        start = I_GetPerfCounter();
+        P_OpenMemorySaveGame();
+        P_ArchiveThinkers();
+        P_CloseMemorySaveGame(&data, &len);
+        *archive += I_GetPerfCounter() - start;
+    }
+
+    if (data == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0 ; i < rounds ; i++)
+    {
+        start = I_GetPerfCounter();
+        P_OpenMemoryLoadGame(data, len);
+        P_UnArchiveThinkers();
+
+        // The world is not unarchived here, so drop sound targets
+        // pointing to the map objects just replaced.
+        for (j = 0 ; j < numsectors ; j++)
+        {
+            sectors[j].soundtarget = NULL;
+        }
+
+        P_RestoreTargets();
+        P_CloseMemoryLoadGame();
+        *unarchive += I_GetPerfCounter() - start;
+    }
+
+    free(data);
+
+    return len;
+}
+
+//
+// G_StressTest
+//  Runs the load test on the map selected by -warp and quits.
+//  Never returns.
+//
+
+void G_StressTest (int tics, int mobjs, const int *types, int numtypes,
+                   int saverounds)
+{
+    static const int defaulttype = 3004;  // Former Human
+    mobjtype_t spawntypes[16];
+    const double freq = (double) I_GetPerfFrequency();
+    uint64_t total = 0, worst = 0, rendertime;
+    uint64_t archivetime = 0, unarchivetime = 0;
+    size_t savesize = 0;
+    int spawned = 0;
+    int thinkers, mobjcount;
+    int peakthinkers, peakmobjs;
+    int zoneused, peakzone;
+    int i;
+
+    if (numtypes <= 0)
+    {
+        types = &defaulttype;
+        numtypes = 1;
+    }
+    if (numtypes > (int) arrlen(spawntypes))
+    {
+        numtypes = (int) arrlen(spawntypes);
+    }
+    for (i = 0 ; i < numtypes ; i++)
+    {
+        spawntypes[i] = G_StressTypeForDoomednum(types[i]);
+    }
+
+    G_InitNew(startskill, startepisode, startmap);
+
+    // Keep the player alive, so monsters stay awake for the whole run.
+    players[consoleplayer].cheats |= CF_GODMODE;
+
+    if (mobjs > 0)
+    {
+        spawned = G_StressSpawn(mobjs, spawntypes, numtypes);
+    }
+
+    peakthinkers = G_StressThinkers(&peakmobjs);
+    peakzone = G_StressZoneUsed();
+
+    for (i = 0 ; i < tics ; i++)
+    {
+        const uint64_t start = I_GetPerfCounter();
+        uint64_t elapsed;
+
+        P_Ticker();
+        gametic++;
+
+        elapsed = I_GetPerfCounter() - start;
+        total += elapsed;
+        if (elapsed > worst)
+        {
+            worst = elapsed;
+        }
+
+        thinkers = G_StressThinkers(&mobjcount);
+        if (thinkers > peakthinkers)
+        {
+            peakthinkers = thinkers;
+        }
+        if (mobjcount > peakmobjs)
+        {
+            peakmobjs = mobjcount;
+        }
+
+        if (i % STRESS_ZONESAMPLE == 0 || i == tics - 1)
+        {
+            zoneused = G_StressZoneUsed();
+            if (zoneused > peakzone)
+            {
+                peakzone = zoneused;
+            }
+        }
+    }
+
+    rendertime = G_StressRender();
+
+    if (saverounds > 0)
+    {
+        savesize = G_StressSaveBench(saverounds, &archivetime, &unarchivetime);
+    }
+
+    if (gamemode == commercial)
+    {
+        printf("\nStress test: MAP%02i, skill %i, %i tics\n",
+               gamemap, gameskill + 1, tics);
+    }
+    else
+    {
+        printf("\nStress test: E%iM%i, skill %i, %i tics\n",
+               gameepisode, gamemap, gameskill + 1, tics);
+    }
+    printf("  Spawned monsters:  %i of %i requested\n", spawned, mobjs);
+    printf("  Peak thinkers:     %i (%i map objects)\n",
+           peakthinkers, peakmobjs);
+    printf("  Playsim time:      %.3f s\n", total / freq);
+    if (total > 0)
+    {
+        printf("  Tics per second:   %.1f\n", tics * freq / total);
+    }
+    printf("  Worst tic:         %.3f ms\n", worst * 1000.0 / freq);
+    printf("  Zone memory:       %i KB peak of %u KB\n",
+           peakzone / 1024, Z_ZoneSize() / 1024);
+    printf("  Render time:       %.3f ms\n", rendertime * 1000.0 / freq);
+    printf("  Sprites:           %i\n", CRLData.numsprites);
+    printf("  Segs:              %i (%i solid)\n",
+           CRLData.numsegs, CRLData.numsolidsegs);
+    printf("  Visplanes:         %i check, %i find\n",
+           CRLData.numcheckplanes, CRLData.numfindplanes);
+    printf("  Openings:          %i\n", CRLData.numopenings);
+
+    if (savesize > 0)
+    {
+        printf("  Thinkers archive:  %i bytes\n", (int) savesize);
+        printf("  Archive time:      %.3f ms average of %i\n",
+               archivetime * 1000.0 / freq / saverounds, saverounds);
+        printf("  Unarchive time:    %.3f ms average of %i\n",
+               unarchivetime * 1000.0 / freq / saverounds, saverounds);
+    }
+
+    I_Quit();
+}
@@ -0,0 +1,1207 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//  Demo verification.
+//
+//  Recording stores a compact hash of the game state every few tics
+//  in a demo footer lump, and playback compares against it to report
+//  the first tic and the map objects where a desync shows.
+//
+//  The runner plays every demo of a list in its own worker process
+//  (this program, started again with -playdemo and -demostate),
+//  collects the end-of-demo state each worker writes and compares it
+//  with the expected results.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "SDL.h"
+
+#include "doomstat.h"
+#include "g_verify.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "p_local.h"
+
+#include "crlcore.h"
+#include "crlfunc.h"
+
+
+// Demo tics between state hashes, unless set with -demohashtics.
+#define DEMOHASH_INTERVAL  TICRATE
+
+// Map objects are hashed into this many groups by their thinker order,
+// so a mismatch narrows down which of them desynced.
+#define DEMOHASH_BUCKETS  16
+
+#define DEMOHASH_VERSION  1
+#define DEMOHASH_HEADERSIZE  4
+#define DEMOHASH_SAMPLESIZE  (8 + DEMOHASH_BUCKETS)
+
+typedef struct
+{
+    byte            valid;
+    byte            rng;
+    unsigned short  mobjs;
+    unsigned int    players;
+    byte            buckets[DEMOHASH_BUCKETS];
+} demohash_t;
+
+// Worker processes running at once, at most.
+#define VERIFY_MAXJOBS  64
+
+// Longest state line a worker writes.
+#define VERIFY_STATELEN  512
+
+typedef enum
+{
+    VERIFY_PENDING,
+    VERIFY_OK,
+    VERIFY_NEW,
+    VERIFY_MISMATCH,
+    VERIFY_FAILED
+} verifystatus_t;
+
+typedef struct
+{
+    char           *demo;
+    char           *expected;
+    char           *state;
+    verifystatus_t  status;
+} verifydemo_t;
+
+#ifdef _WIN32
+typedef HANDLE verifyproc_t;
+#else
+typedef pid_t verifyproc_t;
+#endif
+
+typedef struct
+{
+    verifyproc_t  proc;
+    int           demo;
+    char         *statefile;
+} verifyjob_t;
+
+static const char *const verifystatusname[] = {
+    "PENDING", "OK", "NEW", "MISMATCH", "FAILED"
+};
+
+
+// =============================================================================
+//
+//                                 State hashes
+//
+// =============================================================================
+
+//
+// G_VerifyHashMobj
+//  FNV-1a over a map object's type, position, momentum, angle, state
+//  and health. Pointers are left out, so hashes are comparable between
+//  runs and builds.
+//
+
+#define FNV_OFFSET  2166136261u
+
+static unsigned int G_VerifyHashInt (unsigned int hash, unsigned int val)
+{
+    int i;
+
+    for (i = 0 ; i < 4 ; i++, val >>= 8)
+    {
+        hash = (hash ^ (val & 0xff)) * 16777619u;
+    }
+
+    return hash;
+}
+
+static unsigned int G_VerifyHashMobj (unsigned int hash, const mobj_t *mo)
+{
+    hash = G_VerifyHashInt(hash, mo->type);
+    hash = G_VerifyHashInt(hash, mo->x);
+    hash = G_VerifyHashInt(hash, mo->y);
+    hash = G_VerifyHashInt(hash, mo->z);
+    hash = G_VerifyHashInt(hash, mo->momx);
+    hash = G_VerifyHashInt(hash, mo->momy);
+    hash = G_VerifyHashInt(hash, mo->momz);
+    hash = G_VerifyHashInt(hash, mo->angle);
+    hash = G_VerifyHashInt(hash, mo->state - states);
+    hash = G_VerifyHashInt(hash, mo->tics);
+    hash = G_VerifyHashInt(hash, mo->flags);
+    hash = G_VerifyHashInt(hash, mo->health);
+
+    return hash;
+}
+
+static unsigned int G_VerifyThinkerHash (int *mobjs)
+{
+    unsigned int hash = FNV_OFFSET;
+    thinker_t *th;
+
+    *mobjs = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+        if (th->function.acp1 == (actionf_p1) P_MobjThinker)
+        {
+            hash = G_VerifyHashMobj(hash, (const mobj_t *) th);
+            (*mobjs)++;
+        }
+    }
+
+    return hash;
+}
+
+// =============================================================================
+//
+//                                 Demo hashes
+//
+// =============================================================================
+
+// Hashes recorded, or read from the demo being played back. Sample n
+// is taken at demo tic (n + 1) * hashinterval.
+static demohash_t *hashes;
+static int numhashes, maxhashes;
+static int hashinterval = DEMOHASH_INTERVAL;
+static int lasthashtic;
+
+// First demo tic a desync was seen at, -1 if none.
+static int desynctic = -1;
+
+static byte G_VerifyFoldHash (unsigned int hash)
+{
+    return (hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24)) & 0xff;
+}
+
+static unsigned int G_VerifyHashPlayers (void)
+{
+    unsigned int hash = FNV_OFFSET;
+    int i;
+
+    for (i = 0 ; i < MAXPLAYERS ; i++)
+    {
+        const player_t *const player = &players[i];
+
+        if (!playeringame[i])
+        {
+            continue;
+        }
+
+        if (player->mo != NULL)
+        {
+            hash = G_VerifyHashMobj(hash, player->mo);
+        }
+
+        hash = G_VerifyHashInt(hash, player->playerstate);
+        hash = G_VerifyHashInt(hash, player->health);
+        hash = G_VerifyHashInt(hash, player->armorpoints);
+        hash = G_VerifyHashInt(hash, player->readyweapon);
+        hash = G_VerifyHashInt(hash, player->killcount);
+        hash = G_VerifyHashInt(hash, player->itemcount);
+        hash = G_VerifyHashInt(hash, player->secretcount);
+    }
+
+    return hash;
+}
+
+static void G_VerifyTakeHash (demohash_t *sample)
+{
+    unsigned int buckets[DEMOHASH_BUCKETS];
+    thinker_t *th;
+    int i;
+
+    for (i = 0 ; i < DEMOHASH_BUCKETS ; i++)
+    {
+        buckets[i] = FNV_OFFSET;
+    }
+
+    sample->valid = 1;
+    sample->rng = prndindex;
+    sample->mobjs = 0;
+    sample->players = G_VerifyHashPlayers();
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+        if (th->function.acp1 == (actionf_p1) P_MobjThinker)
+        {
+            unsigned int *const bucket =
+                &buckets[sample->mobjs % DEMOHASH_BUCKETS];
+
+            *bucket = G_VerifyHashMobj(*bucket, (const mobj_t *) th);
+            sample->mobjs++;
+        }
+    }
+
+    for (i = 0 ; i < DEMOHASH_BUCKETS ; i++)
+    {
+        sample->buckets[i] = G_VerifyFoldHash(buckets[i]);
+    }
+}
+
+static boolean G_VerifySameHash (const demohash_t *a, const demohash_t *b)
+{
+    return a->rng == b->rng && a->mobjs == b->mobjs && a->players == b->players
+        && !memcmp(a->buckets, b->buckets, DEMOHASH_BUCKETS);
+}
+
+static void G_VerifyReportDesync (const demohash_t *want,
+                                  const demohash_t *got, int index)
+{
+    const int from = index * hashinterval;
+    const int to = from + hashinterval;
+    static char msg[32];
+    int i;
+
+    desynctic = to;
+
+    fprintf(stderr, "Demo desync between tics %d and %d (%d:%02d):\n",
+            from, to, to / TICRATE / 60, to / TICRATE % 60);
+
+    if (got->rng != want->rng)
+    {
+        fprintf(stderr, "    RNG index %d, recorded %d\n", got->rng, want->rng);
+    }
+
+    if (got->players != want->players)
+    {
+        for (i = 0 ; i < MAXPLAYERS ; i++)
+        {
+            if (playeringame[i] && players[i].mo != NULL)
+            {
+                fprintf(stderr, "    player %d differs, at (%d, %d, %d)\n",
+                        i + 1, players[i].mo->x >> FRACBITS,
+                        players[i].mo->y >> FRACBITS,
+                        players[i].mo->z >> FRACBITS);
+            }
+        }
+    }
+
+    if (got->mobjs != want->mobjs)
+    {
+        fprintf(stderr, "    %d map objects, recorded %d\n",
+                got->mobjs, want->mobjs);
+    }
+
+    // List the map objects of the first group that differs. Objects
+    // are grouped by thinker order, so this only means something as
+    // long as the same objects exist on both sides.
+    for (i = 0 ; i < DEMOHASH_BUCKETS ; i++)
+    {
+        if (got->buckets[i] != want->buckets[i])
+        {
+            thinker_t *th;
+            int mobjnum = 0;
+
+            fprintf(stderr, "    map objects differ, one of:\n");
+
+            for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+            {
+                const mobj_t *const mo = (const mobj_t *) th;
+
+                if (th->function.acp1 != (actionf_p1) P_MobjThinker)
+                {
+                    continue;
+                }
+
+                if (mobjnum % DEMOHASH_BUCKETS == i)
+                {
+                    fprintf(stderr, "        #%d type %d (thing %d) at "
+                            "(%d, %d, %d), health %d\n", mobjnum, mo->type,
+                            mo->info->doomednum, mo->x >> FRACBITS,
+                            mo->y >> FRACBITS, mo->z >> FRACBITS,
+                            mo->health);
+                }
+
+                mobjnum++;
+            }
+
+            break;
+        }
+    }
+
+    M_snprintf(msg, sizeof(msg), "DEMO DESYNC AT %d:%02d",
+               to / TICRATE / 60, to / TICRATE % 60);
+    CRL_SetMessage(&players[consoleplayer], msg, false, NULL);
+}
+
+//
+// G_VerifyRecordStart
+//  Called when demo recording begins.
+//
+
+void G_VerifyRecordStart (void)
+{
+    int p;
+
+    numhashes = 0;
+    lasthashtic = 0;
+    hashinterval = DEMOHASH_INTERVAL;
+
+    //!
+    // @arg <tics>
+    // @category demo
+    //
+    // Store a hash of the game state every given number of tics in
+    // recorded demos (35 by default, 0 to disable, at most 65535).
+    // Playback reports the first tic where the game state differs
+    // from the hashes.
+    //
+
+    p = M_CheckParmWithArgs("-demohashtics", 1);
+
+    if (p)
+    {
+        // The interval is stored in 16 bits in the demo footer.
+        hashinterval = BETWEEN(0, 65535, atoi(myargv[p + 1]));
+    }
+}
+
+static int G_VerifyReadShort (const byte *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static int G_VerifyReadLong (const byte *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static void G_VerifyReadHashLump (const byte *lump, int size)
+{
+    int i;
+
+    if (size < DEMOHASH_HEADERSIZE || lump[0] != DEMOHASH_VERSION
+     || lump[1] != DEMOHASH_BUCKETS || G_VerifyReadShort(lump + 2) <= 0)
+    {
+        return;
+    }
+
+    hashinterval = G_VerifyReadShort(lump + 2);
+    numhashes = (size - DEMOHASH_HEADERSIZE) / DEMOHASH_SAMPLESIZE;
+
+    if (numhashes > maxhashes)
+    {
+        maxhashes = numhashes;
+        hashes = I_Realloc(hashes, maxhashes * sizeof(*hashes));
+    }
+
+    lump += DEMOHASH_HEADERSIZE;
+
+    for (i = 0 ; i < numhashes ; i++, lump += DEMOHASH_SAMPLESIZE)
+    {
+        hashes[i].valid = lump[0];
+        hashes[i].rng = lump[1];
+        hashes[i].mobjs = G_VerifyReadShort(lump + 2);
+        hashes[i].players = G_VerifyReadLong(lump + 4);
+        memcpy(hashes[i].buckets, lump + 8, DEMOHASH_BUCKETS);
+    }
+}
+
+//
+// G_VerifyPlaybackStart
+//  Called when demo playback begins, with the data following the end
+//  of the demo. Picks up the hashes if the footer has them.
+//
+
+void G_VerifyPlaybackStart (const byte *footer, int size)
+{
+    int numlumps, infotableofs, i;
+
+    numhashes = 0;
+    lasthashtic = 0;
+    desynctic = -1;
+
+    if (size < 12 || memcmp(footer, "PWAD", 4))
+    {
+        return;
+    }
+
+    numlumps = G_VerifyReadLong(footer + 4);
+    infotableofs = G_VerifyReadLong(footer + 8);
+
+    if (numlumps < 0 || infotableofs < 0
+     || infotableofs > size || numlumps > (size - infotableofs) / 16)
+    {
+        return;
+    }
+
+    for (i = 0 ; i < numlumps ; i++)
+    {
+        const byte *const info = footer + infotableofs + i * 16;
+        const int filepos = G_VerifyReadLong(info);
+        const int filesize = G_VerifyReadLong(info + 4);
+
+        if (!strncmp((const char *) info + 8, DEMOHASH_LUMPNAME, 8)
+         && filepos >= 0 && filesize >= 0 && filepos <= size - filesize)
+        {
+            G_VerifyReadHashLump(footer + filepos, filesize);
+            break;
+        }
+    }
+}
+
+//
+// G_VerifyTicker
+//  Called at the end of every game tic. Takes a state hash every few
+//  demo tics; stores it when recording and compares it when playing
+//  back.
+//
+
+void G_VerifyTicker (void)
+{
+    demohash_t sample;
+    int index;
+
+    if ((!demorecording && !demoplayback) || hashinterval <= 0
+     || defdemotics <= 0 || defdemotics % hashinterval != 0
+     || defdemotics == lasthashtic)
+    {
+        return;
+    }
+
+    lasthashtic = defdemotics;
+    index = defdemotics / hashinterval - 1;
+
+    // Nothing to store or compare against.
+    if (!demorecording && (desynctic >= 0 || index >= numhashes))
+    {
+        return;
+    }
+
+    G_VerifyTakeHash(&sample);
+
+    if (demoplayback && desynctic < 0 && index < numhashes
+     && hashes[index].valid && !G_VerifySameHash(&hashes[index], &sample))
+    {
+        G_VerifyReportDesync(&hashes[index], &sample, index);
+    }
+
+    if (demorecording)
+    {
+        if (index >= maxhashes)
+        {
+            maxhashes = MAX(index + 1, maxhashes * 2);
+            hashes = I_Realloc(hashes, maxhashes * sizeof(*hashes));
+        }
+
+        // Tics missed while playing back a demo without hashes before
+        // continuing it are left out of the comparison.
+        while (numhashes < index)
+        {
+            hashes[numhashes++].valid = 0;
+        }
+
+        hashes[index] = sample;
+        numhashes = index + 1;
+    }
+}
+
+//
+// G_VerifyWriteDemoHashes
+//  Writes the recorded hashes as demo footer lump data. Returns its
+//  size, 0 if there is nothing to write.
+//
+
+size_t G_VerifyWriteDemoHashes (MEMFILE *stream)
+{
+    byte data[DEMOHASH_SAMPLESIZE];
+    int i;
+
+    if (numhashes == 0)
+    {
+        return 0;
+    }
+
+    data[0] = DEMOHASH_VERSION;
+    data[1] = DEMOHASH_BUCKETS;
+    data[2] = hashinterval & 0xff;
+    data[3] = (hashinterval >> 8) & 0xff;
+    mem_fwrite(data, 1, DEMOHASH_HEADERSIZE, stream);
+
+    for (i = 0 ; i < numhashes ; i++)
+    {
+        const demohash_t *const sample = &hashes[i];
+
+        data[0] = sample->valid;
+        data[1] = sample->rng;
+        data[2] = sample->mobjs & 0xff;
+        data[3] = (sample->mobjs >> 8) & 0xff;
+        data[4] = sample->players & 0xff;
+        data[5] = (sample->players >> 8) & 0xff;
+        data[6] = (sample->players >> 16) & 0xff;
+        data[7] = (sample->players >> 24) & 0xff;
+        memcpy(data + 8, sample->buckets, DEMOHASH_BUCKETS);
+        mem_fwrite(data, 1, DEMOHASH_SAMPLESIZE, stream);
+    }
+
+    return DEMOHASH_HEADERSIZE + (size_t) numhashes * DEMOHASH_SAMPLESIZE;
+}
+
+// =============================================================================
+//
+//                                   Worker
+//
+// =============================================================================
+
+static void G_VerifyFormatState (char *buf, size_t len)
+{
+    int mobjs;
+    const unsigned int hash = G_VerifyThinkerHash(&mobjs);
+    size_t pos;
+    int i;
+
+    M_snprintf(buf, len, "tics=%d map=%d,%d rng=%d hash=%08x mobjs=%d "
+               "totals=%d,%d,%d",
+               defdemotics, gameepisode, gamemap, prndindex, hash, mobjs,
+               totalkills, totalitems, totalsecret);
+
+    if (desynctic >= 0)
+    {
+        pos = strlen(buf);
+        M_snprintf(buf + pos, len - pos, " desync=%d", desynctic);
+    }
+
+    for (i = 0 ; i < MAXPLAYERS ; i++)
+    {
+        const player_t *const player = &players[i];
+
+        if (!playeringame[i])
+        {
+            continue;
+        }
+
+        pos = strlen(buf);
+
+        if (player->mo != NULL)
+        {
+            M_snprintf(buf + pos, len - pos, " p%d=%d,%d,%d,%u,%d,%d,%d,%d,%d",
+                       i, player->mo->x, player->mo->y, player->mo->z,
+                       player->mo->angle, player->health, player->armorpoints,
+                       player->killcount, player->itemcount,
+                       player->secretcount);
+        }
+        else
+        {
+            M_snprintf(buf + pos, len - pos, " p%d=none,%d,%d,%d",
+                       i, player->killcount, player->itemcount,
+                       player->secretcount);
+        }
+    }
+}
+
+//
+// G_VerifyWriteState
+//  Called when demo playback ends. With -demostate, writes a line
+//  describing the final game state for the verification runner.
+//
+
+void G_VerifyWriteState (void)
+{
+    char state[VERIFY_STATELEN];
+    FILE *file;
+    int p;
+
+    //!
+    // @arg <file>
+    // @category demo
+    //
+    // When demo playback ends, write the final game state (tics, map,
+    // player positions, kill/item/secret counts and a hash of all map
+    // objects) to the given file. Used by -verifydemos workers.
+    //
+
+    p = M_CheckParmWithArgs("-demostate", 1);
+
+    if (!p)
+    {
+        return;
+    }
+
+    G_VerifyFormatState(state, sizeof(state));
+
+    file = M_fopen(myargv[p + 1], "w");
+
+    if (file != NULL)
+    {
+        fprintf(file, "%s\n", state);
+        fclose(file);
+    }
+}
+
+// =============================================================================
+//
+//                                   Runner
+//
+// =============================================================================
+
+static char *G_VerifyStrip (char *line)
+{
+    char *end;
+
+    while (*line == ' ' || *line == '\t')
+    {
+        line++;
+    }
+
+    end = line + strlen(line);
+
+    while (end > line && (end[-1] == '\n' || end[-1] == '\r'
+                       || end[-1] == ' ' || end[-1] == '\t'))
+    {
+        *--end = '\0';
+    }
+
+    return line;
+}
+
+//
+// G_VerifyReadList
+//  One demo per line, empty lines and lines starting with # skipped.
+//
+
+static verifydemo_t *G_VerifyReadList (const char *filename, int *count)
+{
+    verifydemo_t *demos = NULL;
+    int size = 0;
+    char line[1024];
+    FILE *file;
+
+    *count = 0;
+
+    file = M_fopen(filename, "r");
+
+    if (file == NULL)
+    {
+        I_Error("G_VerifyDemos: can't open %s", filename);
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        const char *const name = G_VerifyStrip(line);
+
+        if (name[0] == '\0' || name[0] == '#')
+        {
+            continue;
+        }
+
+        if (*count == size)
+        {
+            size = size ? size * 2 : 64;
+            demos = I_Realloc(demos, size * sizeof(*demos));
+        }
+
+        memset(&demos[*count], 0, sizeof(*demos));
+        demos[*count].demo = M_StringDuplicate(name);
+        (*count)++;
+    }
+
+    fclose(file);
+
+    return demos;
+}
+
+//
+// G_VerifyReadExpected
+//  Same format as the -verifyout report: demo, tab, state.
+//
+
+static void G_VerifyReadExpected (const char *filename, verifydemo_t *demos,
+                                  int count)
+{
+    char line[VERIFY_STATELEN + 1024];
+    FILE *file;
+    int i;
+
+    file = M_fopen(filename, "r");
+
+    if (file == NULL)
+    {
+        I_Error("G_VerifyDemos: can't open %s", filename);
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *const tab = strchr(line, '\t');
+
+        if (tab == NULL)
+        {
+            continue;
+        }
+
+        *tab = '\0';
+
+        for (i = 0 ; i < count ; i++)
+        {
+            if (!strcmp(demos[i].demo, line))
+            {
+                free(demos[i].expected);
+                demos[i].expected = M_StringDuplicate(G_VerifyStrip(tab + 1));
+                break;
+            }
+        }
+    }
+
+    fclose(file);
+}
+
+//
+// G_VerifyWorkerArgs
+//  This program's own command line, without the runner's options,
+//  plus the options making it a worker for one demo.
+//
+
+static char **G_VerifyWorkerArgs (const char *demo, const char *statefile)
+{
+    static const char *const skipparms[] = {
+        "-verifydemos", "-verifyjobs", "-verifyexpect", "-verifyout", NULL
+    };
+    char **argv = malloc((myargc + 9) * sizeof(*argv));
+    int argc = 0;
+    int i, j;
+
+    for (i = 0 ; i < myargc ; i++)
+    {
+        for (j = 0 ; skipparms[j] != NULL ; j++)
+        {
+            if (!strcasecmp(myargv[i], skipparms[j]))
+            {
+                break;
+            }
+        }
+
+        if (skipparms[j] != NULL)
+        {
+            i++;  // Skip the value too.
+            continue;
+        }
+
+        argv[argc++] = myargv[i];
+    }
+
+    argv[argc++] = "-playdemo";
+    argv[argc++] = (char *) demo;
+    argv[argc++] = "-demostate";
+    argv[argc++] = (char *) statefile;
+    argv[argc++] = "-nosound";
+    argv[argc++] = "-nogui";
+    argv[argc] = NULL;
+
+    return argv;
+}
+
+#ifdef _WIN32
+
+// Appends one argument, quoted the way CommandLineToArgvW splits it.
+
+static void G_VerifyQuoteArg (wchar_t *cmd, const char *arg)
+{
+    wchar_t *warg;
+    wchar_t *out = cmd + wcslen(cmd);
+    const wchar_t *c;
+    int slashes = 0;
+
+    if (out != cmd)
+    {
+        *out++ = L' ';
+    }
+
+    *out++ = L'"';
+
+    warg = M_ConvertUtf8ToWide(arg);
+
+    for (c = warg ; c != NULL && *c != L'\0' ; c++)
+    {
+        if (*c == L'\\')
+        {
+            slashes++;
+        }
+        else
+        {
+            if (*c == L'"')
+            {
+                // Backslashes before a quote are doubled, then escape it.
+                for ( ; slashes >= 0 ; slashes--)
+                {
+                    *out++ = L'\\';
+                }
+            }
+            slashes = 0;
+        }
+
+        *out++ = *c;
+    }
+
+    // Backslashes before the closing quote are doubled.
+    for ( ; slashes > 0 ; slashes--)
+    {
+        *out++ = L'\\';
+    }
+
+    *out++ = L'"';
+    *out = L'\0';
+
+    free(warg);
+}
+
+static boolean G_VerifySpawn (char **argv, verifyproc_t *proc)
+{
+    STARTUPINFOW startup_info;
+    PROCESS_INFORMATION proc_info;
+    wchar_t exe_path[MAX_PATH];
+    size_t len = 1;
+    wchar_t *cmd;
+    boolean result;
+    int i;
+
+    // Worst case every character is escaped.
+    for (i = 0 ; argv[i] != NULL ; i++)
+    {
+        len += strlen(argv[i]) * 2 + 4;
+    }
+
+    cmd = calloc(len, sizeof(*cmd));
+
+    for (i = 0 ; argv[i] != NULL ; i++)
+    {
+        G_VerifyQuoteArg(cmd, argv[i]);
+    }
+
+    GetModuleFileNameW(NULL, exe_path, MAX_PATH);
+
+    memset(&startup_info, 0, sizeof(startup_info));
+    memset(&proc_info, 0, sizeof(proc_info));
+    startup_info.cb = sizeof(startup_info);
+
+    result = CreateProcessW(exe_path, cmd, NULL, NULL, FALSE,
+                            CREATE_NO_WINDOW, NULL, NULL,
+                            &startup_info, &proc_info) != 0;
+
+    if (result)
+    {
+        CloseHandle(proc_info.hThread);
+        *proc = proc_info.hProcess;
+    }
+
+    free(cmd);
+
+    return result;
+}
+
+// Waits for any of the workers to exit. Returns its index.
+
+static int G_VerifyWaitAny (const verifyjob_t *jobs, int count, int *code)
+{
+    HANDLE handles[VERIFY_MAXJOBS];
+    DWORD exit_code = 1;
+    DWORD which;
+    int i;
+
+    for (i = 0 ; i < count ; i++)
+    {
+        handles[i] = jobs[i].proc;
+    }
+
+    which = WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+
+    if (which >= WAIT_OBJECT_0 + count)
+    {
+        I_Error("G_VerifyDemos: waiting for workers failed");
+    }
+
+    i = which - WAIT_OBJECT_0;
+
+    GetExitCodeProcess(handles[i], &exit_code);
+    CloseHandle(handles[i]);
+    *code = (int) exit_code;
+
+    return i;
+}
+
+#else
+
+static boolean G_VerifySpawn (char **argv, verifyproc_t *proc)
+{
+    const pid_t pid = fork();
+
+    if (pid < 0)
+    {
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        // Keep the runner's console readable.
+        const int devnull = open("/dev/null", O_WRONLY);
+
+        if (devnull >= 0)
+        {
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+            close(devnull);
+        }
+
+        execvp(argv[0], argv);
+        _exit(0x80);
+    }
+
+    *proc = pid;
+
+    return true;
+}
+
+static int G_VerifyWaitAny (const verifyjob_t *jobs, int count, int *code)
+{
+    int status;
+    pid_t pid;
+    int i;
+
+    for (;;)
+    {
+        pid = waitpid(-1, &status, 0);
+
+        if (pid < 0)
+        {
+            I_Error("G_VerifyDemos: waiting for workers failed");
+        }
+
+        for (i = 0 ; i < count ; i++)
+        {
+            if (jobs[i].proc == pid)
+            {
+                *code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                return i;
+            }
+        }
+    }
+}
+
+#endif
+
+static boolean G_VerifyStartJob (verifyjob_t *job, const verifydemo_t *demo,
+                                 int index)
+{
+    char name[64];
+    char **argv;
+    boolean result;
+
+#ifdef _WIN32
+    M_snprintf(name, sizeof(name), "crl-verify-%lu-%d.txt",
+               (unsigned long) GetCurrentProcessId(), index);
+#else
+    M_snprintf(name, sizeof(name), "crl-verify-%ld-%d.txt",
+               (long) getpid(), index);
+#endif
+
+    job->demo = index;
+    job->statefile = M_TempFile(name);
+    M_remove(job->statefile);
+
+    argv = G_VerifyWorkerArgs(demo->demo, job->statefile);
+    result = G_VerifySpawn(argv, &job->proc);
+    free(argv);
+
+    return result;
+}
+
+static void G_VerifyFinishJob (verifyjob_t *job, verifydemo_t *demo, int code)
+{
+    char line[VERIFY_STATELEN];
+    FILE *file;
+
+    demo->status = VERIFY_FAILED;
+
+    file = M_fopen(job->statefile, "r");
+
+    if (file != NULL)
+    {
+        if (fgets(line, sizeof(line), file) != NULL && code == 0)
+        {
+            demo->state = M_StringDuplicate(G_VerifyStrip(line));
+
+            if (demo->expected == NULL)
+            {
+                demo->status = VERIFY_NEW;
+            }
+            else if (!strcmp(demo->expected, demo->state))
+            {
+                demo->status = VERIFY_OK;
+            }
+            else
+            {
+                demo->status = VERIFY_MISMATCH;
+            }
+        }
+
+        fclose(file);
+        M_remove(job->statefile);
+    }
+
+    free(job->statefile);
+    job->statefile = NULL;
+}
+
+//
+// G_VerifyDemos
+//  Plays every demo of the list in parallel workers and reports
+//  results. Never returns; exits with an error if any demo failed or
+//  did not match its expected state.
+//
+
+void G_VerifyDemos (const char *listfile, int jobs)
+{
+    verifyjob_t running[VERIFY_MAXJOBS];
+    verifydemo_t *demos;
+    const char *outfile = NULL;
+    int numdemos, numrunning = 0, next = 0, done = 0;
+    int counts[VERIFY_FAILED + 1] = {0};
+    const uint64_t start = I_GetTimeUS();
+    int p, i;
+
+    demos = G_VerifyReadList(listfile, &numdemos);
+
+    //!
+    // @arg <file>
+    // @category demo
+    //
+    // Expected results for -verifydemos, in the format written by
+    // -verifyout.
+    //
+
+    p = M_CheckParmWithArgs("-verifyexpect", 1);
+
+    if (p)
+    {
+        G_VerifyReadExpected(myargv[p + 1], demos, numdemos);
+    }
+
+    //!
+    // @arg <file>
+    // @category demo
+    //
+    // Write the end-of-demo states found by -verifydemos to the given
+    // file, for use with -verifyexpect.
+    //
+
+    p = M_CheckParmWithArgs("-verifyout", 1);
+
+    if (p)
+    {
+        outfile = myargv[p + 1];
+    }
+
+    if (jobs <= 0)
+    {
+        jobs = SDL_GetCPUCount();
+    }
+    jobs = BETWEEN(1, VERIFY_MAXJOBS, jobs);
+
+    // Workers only need a window to exist, not to be seen or heard.
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+    printf("Verifying %d demos with %d workers.\n", numdemos, jobs);
+
+    while (done < numdemos)
+    {
+        int code, j;
+
+        while (numrunning < jobs && next < numdemos)
+        {
+            if (G_VerifyStartJob(&running[numrunning], &demos[next], next))
+            {
+                numrunning++;
+            }
+            else
+            {
+                demos[next].status = VERIFY_FAILED;
+                done++;
+            }
+            next++;
+        }
+
+        if (numrunning == 0)
+        {
+            continue;
+        }
+
+        j = G_VerifyWaitAny(running, numrunning, &code);
+        i = running[j].demo;
+
+        G_VerifyFinishJob(&running[j], &demos[i], code);
+        running[j] = running[--numrunning];
+        done++;
+
+        printf("[%d/%d] %s: %s\n", done, numdemos, demos[i].demo,
+               verifystatusname[demos[i].status]);
+
+        if (demos[i].status == VERIFY_MISMATCH)
+        {
+            printf("    expected: %s\n    actual:   %s\n",
+                   demos[i].expected, demos[i].state);
+        }
+    }
+
+    if (outfile != NULL)
+    {
+        FILE *const file = M_fopen(outfile, "w");
+
+        if (file == NULL)
+        {
+            I_Error("G_VerifyDemos: can't write %s", outfile);
+        }
+
+        for (i = 0 ; i < numdemos ; i++)
+        {
+            if (demos[i].state != NULL)
+            {
+                fprintf(file, "%s\t%s\n", demos[i].demo, demos[i].state);
+            }
+        }
+
+        fclose(file);
+    }
+
+    for (i = 0 ; i < numdemos ; i++)
+    {
+        counts[demos[i].status]++;
+    }
+
+    printf("\nVerified %d demos in %.1f s: %d ok, %d new, %d mismatched, "
+           "%d failed\n", numdemos, (I_GetTimeUS() - start) / 1000000.0,
+           counts[VERIFY_OK], counts[VERIFY_NEW], counts[VERIFY_MISMATCH],
+           counts[VERIFY_FAILED]);
+
+    if (counts[VERIFY_MISMATCH] > 0 || counts[VERIFY_FAILED] > 0)
+    {
+        i_error_safe = true;
+        I_Error("Demo verification: %d mismatched, %d failed",
+                counts[VERIFY_MISMATCH], counts[VERIFY_FAILED]);
+    }
+
+    I_Quit();
+}
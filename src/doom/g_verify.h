@@ -0,0 +1,29 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+#pragma once
+
+#include "doomtype.h"
+#include "memio.h"
+
+// Demo footer lump holding the state hashes.
+#define DEMOHASH_LUMPNAME "TICHASH"
+
+void G_VerifyRecordStart(void);
+void G_VerifyPlaybackStart(const byte *footer, int size);
+void G_VerifyTicker(void);
+size_t G_VerifyWriteDemoHashes(MEMFILE *stream);
+
+void G_VerifyWriteState(void);
+void G_VerifyDemos(const char *listfile, int jobs);
@@ -43,6 +43,7 @@
 #include "r_local.h"
 #include "g_game.h"
 #include "m_argv.h"
+#include "m_asyncwrite.h"
 #include "m_controls.h"
 #include "s_sound.h"
 #include "doomstat.h"
@@ -237,6 +238,7 @@ static void M_FinishReadThis(int choice);
 static void M_LoadSelect(int choice);
 static void M_SaveSelect(int choice);
 static void M_ReadSaveStrings(void);
+static void M_InvalidateSaveSlot(int slot);
 static void M_QuickSave(void);
 static void M_QuickLoad(void);
 
@@ -752,6 +754,7 @@ static void M_CRL_Widget_Speed (int choice);
 static void M_CRL_Widget_Time (int choice);
 static void M_CRL_Widget_Powerups (int choice);
 static void M_CRL_Widget_Health (int choice);
+static void M_CRL_Widget_Thinkers (int choice);
 
 static void M_ChooseCRL_Automap (int choice);
 static void M_DrawCRL_Automap (void);
@@ -796,6 +799,7 @@ static void M_CRL_Misc_RewindDepth (int choice);
 static void M_CRL_Misc_RewindTimeout (int choice);
 static void M_CRL_Misc_ShotFormat (int choice);
 static void M_CRL_Misc_ShotSetup (int choice);
+static void M_CRL_Misc_ShotNative (int choice);
 
 static void M_ScrollMisc (int choice);
 
@@ -1473,7 +1477,8 @@ static void M_DrawCRL_Video (void)
                  M_Item_Glow(2, crl_vsync ?  GLOW_DARKRED : GLOW_YELLOW));
 
     // Show FPS counter
-    sprintf(str, crl_showfps ? "ON" : "OFF");
+    sprintf(str, crl_showfps == 1 ? "ON" :
+                 crl_showfps == 2 ? "WITH PACING" : "OFF");
     M_WriteText (M_ItemRightAlign(str), 43, str, 
                  M_Item_Glow(3, crl_showfps ? GLOW_GREEN : GLOW_DARKRED));
 
@@ -1564,7 +1569,7 @@ static void M_CRL_VSync (int choice)
 
 static void M_CRL_ShowFPS (int choice)
 {
-    crl_showfps ^= 1;
+    crl_showfps = M_INT_Slider(crl_showfps, 0, 2, choice, false);
 }
 
 static void M_CRL_PixelScaling (int choice)
@@ -3086,6 +3091,7 @@ static menuitem_t CRLMenu_Widgets[]=
     { M_MUL2, "PLAYER SPEED",       M_CRL_Widget_Speed,      'p' },
     { M_MUL2, "POWERUP TIMERS",     M_CRL_Widget_Powerups,   'p' },
     { M_MUL2, "TARGET'S HEALTH",    M_CRL_Widget_Health,     't' },
+    { M_MUL2, "THINKER PROFILER",   M_CRL_Widget_Thinkers,   't' },
 };
 
 static menu_t CRLDef_Widgets =
@@ -3186,6 +3192,11 @@ static void M_DrawCRL_Widgets (void)
     M_WriteText (M_ItemRightAlign(str), 115, str,
                  M_Item_Glow(11, crl_widget_health ? GLOW_GREEN : GLOW_DARKRED));
 
+    // Thinker profiler
+    sprintf(str, crl_widget_thinkers ? "ON" : "OFF");
+    M_WriteText (M_ItemRightAlign(str), 124, str,
+                 M_Item_Glow(12, crl_widget_thinkers ? GLOW_GREEN : GLOW_DARKRED));
+
     // Print informatime message if extended HUD is off.
     if (!crl_extended_hud)
     {
@@ -3253,6 +3264,11 @@ static void M_CRL_Widget_Health (int choice)
     crl_widget_health = M_INT_Slider(crl_widget_health, 0, 4, choice, false);
 }
 
+static void M_CRL_Widget_Thinkers (int choice)
+{
+    crl_widget_thinkers ^= 1;
+}
+
 static void M_CRL_Automap_Rotate (int choice)
 {
     crl_automap_rotate ^= 1;
@@ -3755,7 +3771,7 @@ static menuitem_t CRLMenu_Misc_2[]=
     { M_SKIP, "", 0, '\0' },
     { M_MUL1, "SCREENSHOT FORMAT",         M_CRL_Misc_ShotFormat,     's' },
     { M_MUL1, "", /* Dynamic string */     M_CRL_Misc_ShotSetup,      's' },
-    { M_SKIP, "", 0, '\0' },
+    { M_MUL1, "NATIVE RESOLUTION",         M_CRL_Misc_ShotNative,     'n' },
     { M_SKIP, "", 0, '\0' },
     { M_SKIP, "", 0, '\0' },
     { M_SKIP, "", 0, '\0' },
@@ -3823,6 +3839,11 @@ static void M_DrawCRL_Misc_2 (void)
     M_snprintf(str, 4, "%d", value);
     M_WriteText (M_ItemRightAlign(str), 70, str, M_Item_Glow(6, GLOW_GREEN));
 
+    // Native resolution
+    sprintf(str, screenshots_native ? "ON" : "OFF");
+    M_WriteText (M_ItemRightAlign(str), 79, str,
+                 M_Item_Glow(7, screenshots_native ? GLOW_GREEN : GLOW_DARKRED));
+
     // Dynamic hints for screenshot settings.
     if (itemOn == 5)
     {
@@ -3844,6 +3865,11 @@ static void M_DrawCRL_Misc_2 (void)
             M_WriteTextCentered(106, "DEFAULT LEVEL IS 90",                  cr[CR_GRAY]);
         }
     }
+    if (itemOn == 7)
+    {
+        M_WriteTextCentered(88, "SAVE 320X200 GAME PIXELS",        cr[CR_GRAY]);
+        M_WriteTextCentered(97, "INSTEAD OF THE WINDOW CONTENTS", cr[CR_GRAY]);
+    }
 
     // < Scroll pages >
     M_DrawScrollPages(CRL_MENU_LEFTOFFSET_BIG, 142, 15, "2/2");
@@ -3892,6 +3918,11 @@ static void M_CRL_Misc_ShotSetup (int choice)
     }
 }
 
+static void M_CRL_Misc_ShotNative (int choice)
+{
+    screenshots_native ^= 1;
+}
+
 static void M_ScrollMisc (int choice)
 {
          if (currentMenu == &CRLDef_Misc_1) { M_SetupNextMenu(&CRLDef_Misc_2); }
@@ -3999,6 +4030,151 @@ static void M_CRL_Limits (int choice)
 // =============================================================================
 
 
+// -----------------------------------------------------------------------------
+// [JN] Save slot index.
+//  Description, metadata and preview of every slot are cached in a small
+//  file next to the savegames, so opening the save and load menus does
+//  not have to read every savegame. An entry is used while the savegame
+//  size and modification time still match, otherwise that one file is
+//  read again and the entry is refreshed.
+// -----------------------------------------------------------------------------
+
+#define SAVEINDEX_NAME      "saveindex.dat"
+#define SAVEINDEX_MAGIC     "CRLSIDX"
+#define SAVEINDEX_VERSION   1
+#define SAVEINDEX_SLOTS     (10 * 16)
+
+typedef struct
+{
+    int64_t mtime;
+    int64_t size;
+    char description[SAVESTRINGSIZE];
+    boolean status;
+    boolean preview_present;
+    savegame_meta_t meta;
+    byte preview[V_SAVEPREVIEW_SIZE];
+    boolean valid;
+} saveindex_entry_t;
+
+typedef struct
+{
+    char magic[8];
+    int version;
+    int entrysize;
+    int numentries;
+} saveindex_header_t;
+
+static saveindex_entry_t saveindex[SAVEINDEX_SLOTS];
+static boolean saveindex_loaded;
+
+static char *M_SaveIndexFile (void)
+{
+    static char *filename = NULL;
+
+    if (filename == NULL)
+    {
+        filename = M_StringJoin(savegamedir, SAVEINDEX_NAME, NULL);
+    }
+
+    return filename;
+}
+
+static void M_LoadSaveIndex (void)
+{
+    saveindex_header_t header;
+    FILE *handle;
+
+    saveindex_loaded = true;
+
+    handle = M_fopen(M_SaveIndexFile(), "rb");
+
+    if (handle == NULL)
+    {
+        return;
+    }
+
+    if (fread(&header, sizeof(header), 1, handle) != 1
+    ||  memcmp(header.magic, SAVEINDEX_MAGIC, sizeof(SAVEINDEX_MAGIC)) != 0
+    ||  header.version != SAVEINDEX_VERSION
+    ||  header.entrysize != (int) sizeof(saveindex_entry_t)
+    ||  header.numentries != SAVEINDEX_SLOTS
+    ||  fread(saveindex, sizeof(saveindex), 1, handle) != 1)
+    {
+        // Stale or damaged index, rebuild it from the savegames.
+        memset(saveindex, 0, sizeof(saveindex));
+    }
+
+    fclose(handle);
+}
+
+static void M_WriteSaveIndex (void)
+{
+    saveindex_header_t header;
+    FILE *handle;
+
+    handle = M_fopen(M_SaveIndexFile(), "wb");
+
+    if (handle == NULL)
+    {
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SAVEINDEX_MAGIC, sizeof(SAVEINDEX_MAGIC));
+    header.version = SAVEINDEX_VERSION;
+    header.entrysize = sizeof(saveindex_entry_t);
+    header.numentries = SAVEINDEX_SLOTS;
+
+    if (fwrite(&header, sizeof(header), 1, handle) != 1
+    ||  fwrite(saveindex, sizeof(saveindex), 1, handle) != 1)
+    {
+        fclose(handle);
+        M_remove(M_SaveIndexFile());
+        return;
+    }
+
+    fclose(handle);
+}
+
+// Drop the entry of a slot on the current page.
+
+static void M_InvalidateSaveSlot (int slot)
+{
+    saveindex[10*savepage+slot].valid = false;
+}
+
+// Read description, metadata and preview of one savegame into its entry.
+
+static void M_ReadSaveSlot (FILE *handle, saveindex_entry_t *entry)
+{
+    const size_t retval = fread(entry->description, 1, SAVESTRINGSIZE, handle);
+
+    entry->status = retval == SAVESTRINGSIZE;
+
+    if (entry->status)
+    {
+        byte skill, episode, map;
+        int slot_leveltime;
+
+        entry->meta.present = M_ReadSaveMeta(handle, &skill, &episode,
+                                             &map, &slot_leveltime);
+        if (entry->meta.present)
+        {
+            entry->meta.skill = skill;
+            entry->meta.episode = episode;
+            entry->meta.map = map;
+            entry->meta.leveltime = slot_leveltime;
+        }
+    }
+    else
+    {
+        entry->meta.present = false;
+    }
+
+    entry->preview_present = entry->status
+                          && V_SavePreview_ReadFromFile(handle, entry->preview);
+}
+
 //
 // M_ReadSaveStrings
 //  read the strings from the savegame files
@@ -4008,14 +4184,24 @@ static void M_ReadSaveStrings(void)
     FILE   *handle;
     int     i;
     char    name[256];
+    boolean changed = false;
+
+    // [JN] Let a pending savegame write land first.
+    M_AsyncWriteWait();
+
+    if (!saveindex_loaded)
+    {
+        M_LoadSaveIndex();
+    }
 
     for (i = 0;i < load_end;i++)
     {
-        int retval;
+        saveindex_entry_t *const entry = &saveindex[10*savepage+i];
+        struct stat st;
+
         M_StringCopy(name, P_SaveGameFile(i), sizeof(name));
 
-	handle = M_fopen(name, "rb");
-        if (handle == NULL)
+        if (M_stat(name, &st) != 0)
         {
             M_StringCopy(savegamestrings[i], EMPTYSTRING, SAVESTRINGSIZE);
             LoadMenu[i].status = 0;
@@ -4023,32 +4209,46 @@ static void M_ReadSaveStrings(void)
             savegame_meta[i].present = false;
             continue;
         }
-        retval = fread(&savegamestrings[i], 1, SAVESTRINGSIZE, handle);
-        LoadMenu[i].status = retval == SAVESTRINGSIZE;
 
-        if (LoadMenu[i].status)
+        if (!entry->valid
+        ||  entry->mtime != (int64_t) st.st_mtime
+        ||  entry->size != (int64_t) st.st_size)
         {
-            byte skill, episode, map;
-            int slot_leveltime;
+            handle = M_fopen(name, "rb");
 
-            savegame_meta[i].present = M_ReadSaveMeta(handle, &skill, &episode,
-                                                      &map, &slot_leveltime);
-            if (savegame_meta[i].present)
+            if (handle == NULL)
             {
-                savegame_meta[i].skill = skill;
-                savegame_meta[i].episode = episode;
-                savegame_meta[i].map = map;
-                savegame_meta[i].leveltime = slot_leveltime;
+                M_StringCopy(savegamestrings[i], EMPTYSTRING, SAVESTRINGSIZE);
+                LoadMenu[i].status = 0;
+                savegamepreview_present[i] = false;
+                savegame_meta[i].present = false;
+                continue;
             }
+
+            memset(entry, 0, sizeof(*entry));
+            M_ReadSaveSlot(handle, entry);
+            fclose(handle);
+
+            entry->mtime = st.st_mtime;
+            entry->size = st.st_size;
+            entry->valid = true;
+            changed = true;
         }
-        else
+
+        memcpy(savegamestrings[i], entry->description, SAVESTRINGSIZE);
+        LoadMenu[i].status = entry->status;
+        savegame_meta[i] = entry->meta;
+        savegamepreview_present[i] = entry->preview_present;
+
+        if (entry->preview_present)
         {
-            savegame_meta[i].present = false;
+            memcpy(savegamepreviews[i], entry->preview, V_SAVEPREVIEW_SIZE);
         }
+    }
 
-        savegamepreview_present[i] = LoadMenu[i].status
-                                  && V_SavePreview_ReadFromFile(handle, savegamepreviews[i]);
-	fclose(handle);
+    if (changed)
+    {
+        M_WriteSaveIndex();
     }
 }
 
@@ -4316,6 +4516,9 @@ static void M_DrawSave(void)
 //
 static void M_DoSave(int slot)
 {
+    // [JN] The slot is about to change, even within the same second.
+    M_InvalidateSaveSlot(slot);
+
     G_SaveGame (slot,savegamestrings[slot]);
     M_ClearMenus ();
 
@@ -6868,7 +7071,9 @@ static void M_ConfirmDeleteGameResponse (int key)
 		char name[256];
 
 		M_StringCopy(name, P_SaveGameFile(itemOn), sizeof(name));
+		M_AsyncWriteWait();
 		remove(name);
+		M_InvalidateSaveSlot(itemOn);
 
 		if (itemOn == quickSaveSlot)
 			quickSaveSlot = -1;
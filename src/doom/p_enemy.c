@@ -87,8 +87,9 @@ P_RecursiveSound
   int		soundblocks )
 {
     int		i;
-    line_t*	check;
-    sector_t*	other;
+    const soundedge_t*	edge;
+    fixed_t	soundtop;
+    fixed_t	soundbottom;
 	
     // wake up all monsters in this sector
     if (sec->validcount == validcount
@@ -101,34 +102,31 @@ P_RecursiveSound
     sec->soundtraversed = soundblocks+1;
     sec->soundtarget = soundtarget;
 	
+    // [JN] CRL - Sound propagation mode﻿ for automap.
+    // Set line timer for drawing.
     for (i=0 ;i<sec->linecount ; i++)
-    {
-	check = sec->lines[i];
-
-	// [JN] CRL - Sound propagation mode﻿ for automap.
-	// Set line timer for drawing.
-	check->sndprop_tics = (TICRATE / 3.5);
+	sec->lines[i]->sndprop_tics = (TICRATE / 3.5);
 
-	if (! (check->flags & ML_TWOSIDED) )
-	    continue;
-	
-	P_LineOpening (check);
+    // [JN] Walk precomputed graph built by P_BuildSoundGraph
+    // instead of checking every line of the sector.
+    for (i=0, edge = sec->soundedges ; i<sec->soundedgecount ; i++, edge++)
+    {
+	// same opening calculation as in P_LineOpening
+	soundtop = edge->front->ceilingheight < edge->back->ceilingheight ?
+	           edge->front->ceilingheight : edge->back->ceilingheight;
+	soundbottom = edge->front->floorheight > edge->back->floorheight ?
+	              edge->front->floorheight : edge->back->floorheight;
 
-	if (openrange <= 0)
+	if (soundtop - soundbottom <= 0)
 	    continue;	// closed door
 	
-	if ( sides[ check->sidenum[0] ].sector == sec)
-	    other = sides[ check->sidenum[1] ] .sector;
-	else
-	    other = sides[ check->sidenum[0] ].sector;
-	
-	if (check->flags & ML_SOUNDBLOCK)
+	if (edge->soundblock)
 	{
 	    if (!soundblocks)
-		P_RecursiveSound (other, 1);
+		P_RecursiveSound (edge->other, 1);
 	}
 	else
-	    P_RecursiveSound (other, soundblocks);
+	    P_RecursiveSound (edge->other, soundblocks);
     }
 }
 
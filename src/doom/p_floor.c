@@ -46,6 +46,9 @@ T_MovePlane
     boolean	flag;
     fixed_t	lastpos;
 	
+    // [JN] Sector heights are about to change, cached sight checks are stale.
+    P_SightGeometryChanged();
+
     // [AM] Store old sector heights for interpolation.
     if (sector->oldgametic != gametic)
     {
@@ -274,7 +277,7 @@ EV_DoFloor
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = P_AllocThinker (sizeof(*floor));
 	P_AddThinker (&floor->thinker);
 	sec->specialdata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -478,7 +481,7 @@ EV_BuildStairs
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = P_AllocThinker (sizeof(*floor));
 	P_AddThinker (&floor->thinker);
 	sec->specialdata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -537,7 +540,7 @@ EV_BuildStairs
 					
 		sec = tsec;
 		secnum = newsecnum;
-		floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+		floor = P_AllocThinker (sizeof(*floor));
 
 		P_AddThinker (&floor->thinker);
 
@@ -32,7 +32,7 @@
 //
 // T_FireFlicker
 //
-static void T_FireFlicker (fireflicker_t* flick)
+void T_FireFlicker (fireflicker_t* flick)
 {
     int	amount;
 	
@@ -62,7 +62,7 @@ void P_SpawnFireFlicker (sector_t*	sector)
     // Nothing special about it during gameplay.
     sector->special = 0; 
 	
-    flick = Z_Malloc ( sizeof(*flick), PU_LEVSPEC, 0);
+    flick = P_AllocThinker (sizeof(*flick));
 
     P_AddThinker (&flick->thinker);
 
@@ -117,7 +117,7 @@ void P_SpawnLightFlash (sector_t*	sector)
     // nothing special about it during gameplay
     sector->special = 0;	
 	
-    flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
+    flash = P_AllocThinker (sizeof(*flash));
 
     P_AddThinker (&flash->thinker);
 
@@ -174,7 +174,7 @@ P_SpawnStrobeFlash
 {
     strobe_t*	flash;
 	
-    flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
+    flash = P_AllocThinker (sizeof(*flash));
 
     P_AddThinker (&flash->thinker);
 
@@ -331,7 +331,7 @@ void P_SpawnGlowingLight(sector_t*	sector)
 {
     glow_t*	g;
 	
-    g = Z_Malloc( sizeof(*g), PU_LEVSPEC, 0);
+    g = P_AllocThinker (sizeof(*g));
 
     P_AddThinker(&g->thinker);
 
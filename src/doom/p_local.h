@@ -226,6 +226,10 @@ extern void A_XScream (mobj_t *actor);
 extern void P_ForgetPlayer (const player_t *player);
 extern void P_NoiseAlert (mobj_t *target, mobj_t *emmiter);
 
+extern mobj_t **braintargets;
+extern int      numbraintargets;
+extern int      braintargeton;
+
 // -----------------------------------------------------------------------------
 // P_FLOOR
 // -----------------------------------------------------------------------------
@@ -366,6 +370,7 @@ extern void P_SpawnFireFlicker (sector_t *sector);
 extern void P_SpawnGlowingLight (sector_t *sector);
 extern void P_SpawnLightFlash (sector_t *sector);
 extern void P_SpawnStrobeFlash (sector_t *sector, int fastOrSlow, int inSync);
+extern void T_FireFlicker (fireflicker_t *flick);
 extern void T_Glow (glow_t *g);
 extern void T_LightFlash (lightflash_t *flash);
 extern void T_StrobeFlash (strobe_t *flash);
@@ -601,6 +606,8 @@ extern boolean  P_CloseMemorySaveGame(byte **data, size_t *len);
 extern void     P_CloseMemoryLoadGame(void);
 extern void     P_OpenMemoryLoadGame(byte *data, size_t len);
 extern void     P_OpenMemorySaveGame(void);
+extern void     P_OpenMemorySaveFile(void);
+extern long     P_SaveGameTell(void);
 extern void     P_ArchiveAutomap (void);
 extern void     P_ArchiveOldSpecials (void);
 extern void     P_ArchiveSavePreview (void);
@@ -654,6 +661,8 @@ extern const char *level_name;
 extern fixed_t topslope;
 extern fixed_t bottomslope;
 
+extern void P_SightGeometryChanged (void);
+
 // -----------------------------------------------------------------------------
 // P_SPEC
 // -----------------------------------------------------------------------------
@@ -740,6 +749,9 @@ extern int EV_Teleport (const line_t *line, int side, mobj_t *thing);
 // -----------------------------------------------------------------------------
 
 extern void P_InitThinkers (void);
+extern void P_InitThinkerPools (void);
+extern void *P_AllocThinker (size_t size);
+extern void P_FreeThinker (thinker_t *thinker);
 extern void P_AddThinker (thinker_t *thinker);
 extern void P_RemoveThinker (thinker_t *thinker);
 extern void P_Ticker (void);
@@ -747,6 +759,38 @@ extern void P_Ticker (void);
 // both the head and tail of the thinker list
 extern thinker_t thinkercap;
 
+// [JN] Thinker profiler.
+enum
+{
+    tp_mobj,
+    tp_ceiling,
+    tp_door,
+    tp_floor,
+    tp_plat,
+    tp_flash,
+    tp_strobe,
+    tp_glow,
+    tp_flicker,
+    tp_other,
+    tp_remove,  // Unlinking and freeing of removed thinkers.
+    NUMTHINKERPROFS
+};
+
+typedef struct
+{
+    uint64_t time;   // Performance counter ticks spent.
+    int      calls;  // Number of calls made.
+} thinkerprof_t;
+
+extern void P_ResetThinkerProfiler (void);
+extern void P_DumpThinkerProfiler (void);
+
+extern const char   *thinkerprof_names[NUMTHINKERPROFS];
+extern thinkerprof_t thinkerprof[NUMTHINKERPROFS];    // Last second.
+extern thinkerprof_t thinkerprof_mobj[NUMMOBJTYPES];  // Last second.
+extern int           thinkerprof_tics;
+extern char         *thinkerdump_file;
+
 // -----------------------------------------------------------------------------
 // P_USER
 // -----------------------------------------------------------------------------
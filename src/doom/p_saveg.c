@@ -57,6 +57,7 @@ typedef struct
     size_t position;
     save_mem_mode_t mode;
     boolean owns_buffer;
+    boolean keyframe;   // [JN] Full precision world state for rewind.
 } save_memstream_t;
 
 static save_memstream_t *save_memstream;
@@ -237,7 +238,7 @@ static int saveg_fseek(long position, int whence)
     return fseek(save_stream, position, whence);
 }
 
-void P_OpenMemorySaveGame(void)
+static void saveg_open_memory(boolean keyframe)
 {
     save_stream = NULL;
     save_memstream = calloc(1, sizeof(*save_memstream));
@@ -256,12 +257,32 @@ void P_OpenMemorySaveGame(void)
         {
             save_memstream->mode = SAVE_MEM_WRITE;
             save_memstream->owns_buffer = true;
+            save_memstream->keyframe = keyframe;
         }
     }
 
     savegame_error = (save_memstream == NULL);
 }
 
+// Rewind keyframe, world state is stored with full precision.
+
+void P_OpenMemorySaveGame(void)
+{
+    saveg_open_memory(true);
+}
+
+// [JN] Memory image of a regular savegame file, written out later.
+
+void P_OpenMemorySaveFile(void)
+{
+    saveg_open_memory(false);
+}
+
+long P_SaveGameTell(void)
+{
+    return saveg_ftell();
+}
+
 boolean P_CloseMemorySaveGame(byte **data, size_t *len)
 {
     *data = NULL;
@@ -303,6 +324,7 @@ void P_OpenMemoryLoadGame(byte *data, size_t len)
         save_memstream->position = 0;
         save_memstream->mode = SAVE_MEM_READ;
         save_memstream->owns_buffer = false;
+        save_memstream->keyframe = true;
     }
 
     savegame_error = (save_memstream == NULL);
@@ -358,32 +380,175 @@ char *P_SaveGameFile(int slot)
     return filename;
 }
 
-// Endian-safe integer read/write functions
+static boolean saveg_keyframe(void)
+{
+    return save_memstream != NULL && save_memstream->keyframe;
+}
 
-static byte saveg_read8(void)
+// [JN] Map object numbering. Targets, tracers and sound targets are
+// archived as the position of the map object in the thinker list.
+// The list is numbered once per archive into a table sorted by
+// address, so each lookup is a binary search instead of a list walk.
+
+typedef struct
 {
-    byte result = -1;
+    uintptr_t addr;
+    uint32_t  index;
+} saveg_mobjnum_t;
+
+static saveg_mobjnum_t *saveg_mobjnums;
+static int saveg_nummobjnums;
+static int saveg_maxmobjnums;
+
+static int saveg_cmp_mobjnum(const void *a, const void *b)
+{
+    const uintptr_t x = ((const saveg_mobjnum_t *) a)->addr;
+    const uintptr_t y = ((const saveg_mobjnum_t *) b)->addr;
+
+    return (x > y) - (x < y);
+}
+
+static void saveg_number_mobjs(void)
+{
+    thinker_t *th;
+    uint32_t   i = 1;
 
-    if (saveg_fread(&result, 1, 1) < 1)
+    saveg_nummobjnums = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+        if (th->function.acp1 == (actionf_p1) P_MobjThinker)
+        {
+            if (saveg_nummobjnums == saveg_maxmobjnums)
+            {
+                saveg_maxmobjnums = saveg_maxmobjnums ? saveg_maxmobjnums * 2 : 1024;
+                saveg_mobjnums = I_Realloc(saveg_mobjnums,
+                                           saveg_maxmobjnums * sizeof(*saveg_mobjnums));
+            }
+
+            saveg_mobjnums[saveg_nummobjnums].addr = (uintptr_t) th;
+            saveg_mobjnums[saveg_nummobjnums].index = i++;
+            saveg_nummobjnums++;
+        }
+    }
+
+    qsort(saveg_mobjnums, saveg_nummobjnums, sizeof(*saveg_mobjnums),
+          saveg_cmp_mobjnum);
+}
+
+// Same result as P_ThinkerToIndex, using the table from saveg_number_mobjs.
+
+static uint32_t saveg_mobj_index(const mobj_t *mo)
+{
+    saveg_mobjnum_t key;
+    const saveg_mobjnum_t *found;
+
+    if (!mo)
+    {
+        return 0;
+    }
+
+    key.addr = (uintptr_t) mo;
+    found = bsearch(&key, saveg_mobjnums, saveg_nummobjnums,
+                    sizeof(*saveg_mobjnums), saveg_cmp_mobjnum);
+
+    return found ? found->index : 0;
+}
+
+// [JN] Record staging. Hot record types (map objects, world state and
+// specials) are encoded into a small buffer and handed to saveg_fwrite
+// in one call, and decoded from a buffer filled by a single saveg_fread.
+// The byte layout is the same as writing every field one at a time.
+
+#define SAVEG_STAGESIZE 4096
+
+static byte saveg_stage[SAVEG_STAGESIZE];
+static size_t saveg_stage_len;
+static size_t saveg_stage_pos;
+static boolean saveg_write_staged;
+static boolean saveg_read_staged;
+
+static void saveg_flush_stage(void)
+{
+    if (saveg_stage_len > 0
+    &&  saveg_fwrite(saveg_stage, 1, saveg_stage_len) < saveg_stage_len)
     {
         if (!savegame_error)
         {
-            // [JN] Supress warning, CRL writes some extra data after EOF marker.
-            /*
-            fprintf(stderr, "saveg_read8: Unexpected end of file while "
-                            "reading save game\n");
-            */
+            fprintf(stderr, "saveg_flush_stage: Error while writing save game\n");
 
             savegame_error = true;
         }
     }
 
-    return result;
+    saveg_stage_len = 0;
 }
 
-static void saveg_write8(byte value)
+// Start collecting writes; flushed when the stage fills up and at the end.
+
+static void saveg_begin_write(void)
+{
+    saveg_stage_len = 0;
+    saveg_write_staged = true;
+}
+
+static void saveg_end_write(void)
+{
+    saveg_flush_stage();
+    saveg_write_staged = false;
+}
+
+// Read a whole fixed-size record at once, the following reads are
+// served from the stage until saveg_end_read.
+
+static void saveg_begin_read(size_t size)
+{
+    const size_t got = saveg_fread(saveg_stage, 1, size);
+
+    if (got < size)
+    {
+        memset(saveg_stage + got, 0xff, size - got);
+        savegame_error = true;
+    }
+
+    saveg_stage_len = size;
+    saveg_stage_pos = 0;
+    saveg_read_staged = true;
+}
+
+static void saveg_end_read(void)
+{
+    if (saveg_stage_pos != saveg_stage_len)
+    {
+        I_Error("saveg_end_read: Record size mismatch (%d of %d bytes read)",
+                (int) saveg_stage_pos, (int) saveg_stage_len);
+    }
+
+    saveg_read_staged = false;
+}
+
+// Stream position including the writes still waiting in the stage.
+
+static long saveg_tell(void)
+{
+    return saveg_ftell() + (saveg_write_staged ? (long) saveg_stage_len : 0);
+}
+
+static void saveg_put(const byte *data, size_t size)
 {
-    if (saveg_fwrite(&value, 1, 1) < 1)
+    if (saveg_write_staged)
+    {
+        if (saveg_stage_len + size > SAVEG_STAGESIZE)
+        {
+            saveg_flush_stage();
+        }
+
+        memcpy(saveg_stage + saveg_stage_len, data, size);
+        saveg_stage_len += size;
+        return;
+    }
+
+    if (saveg_fwrite(data, 1, size) < size)
     {
         if (!savegame_error)
         {
@@ -394,68 +559,123 @@ static void saveg_write8(byte value)
     }
 }
 
-static short saveg_read16(void)
+static void saveg_get(byte *data, size_t size)
 {
-    int result;
+    if (saveg_read_staged)
+    {
+        if (saveg_stage_pos + size > saveg_stage_len)
+        {
+            I_Error("saveg_get: Read past the end of a record");
+        }
 
-    result = saveg_read8();
-    result |= saveg_read8() << 8;
+        memcpy(data, saveg_stage + saveg_stage_pos, size);
+        saveg_stage_pos += size;
+        return;
+    }
+
+    if (saveg_fread(data, 1, size) < size)
+    {
+        memset(data, 0xff, size);
+
+        if (!savegame_error)
+        {
+            // [JN] Supress warning, CRL writes some extra data after EOF marker.
+            /*
+            fprintf(stderr, "saveg_read8: Unexpected end of file while "
+                            "reading save game\n");
+            */
+
+            savegame_error = true;
+        }
+    }
+}
+
+// Endian-safe integer read/write functions
+
+static byte saveg_read8(void)
+{
+    byte result;
+
+    saveg_get(&result, 1);
 
     return result;
 }
 
+static void saveg_write8(byte value)
+{
+    saveg_put(&value, 1);
+}
+
+static short saveg_read16(void)
+{
+    byte b[2];
+
+    saveg_get(b, 2);
+
+    return (short) (b[0] | (b[1] << 8));
+}
+
 static void saveg_write16(short value)
 {
-    saveg_write8(value & 0xff);
-    saveg_write8((value >> 8) & 0xff);
+    byte b[2];
+
+    b[0] = value & 0xff;
+    b[1] = (value >> 8) & 0xff;
+
+    saveg_put(b, 2);
 }
 
 static int saveg_read32(void)
 {
-    int result;
+    byte b[4];
 
-    result = saveg_read8();
-    result |= saveg_read8() << 8;
-    result |= saveg_read8() << 16;
-    result |= saveg_read8() << 24;
+    saveg_get(b, 4);
 
-    return result;
+    return (int) ((uint32_t) b[0]
+               | ((uint32_t) b[1] << 8)
+               | ((uint32_t) b[2] << 16)
+               | ((uint32_t) b[3] << 24));
 }
 
 static void saveg_write32(int value)
 {
-    saveg_write8(value & 0xff);
-    saveg_write8((value >> 8) & 0xff);
-    saveg_write8((value >> 16) & 0xff);
-    saveg_write8((value >> 24) & 0xff);
+    byte b[4];
+
+    b[0] = value & 0xff;
+    b[1] = (value >> 8) & 0xff;
+    b[2] = (value >> 16) & 0xff;
+    b[3] = (value >> 24) & 0xff;
+
+    saveg_put(b, 4);
 }
 
 static int64_t saveg_read64(void)
 {
-    int64_t result;
+    byte b[8];
+    uint64_t result = 0;
+    int i;
 
-    result = saveg_read8();
-    result |= (int64_t)saveg_read8() << 8;
-    result |= (int64_t)saveg_read8() << 16;
-    result |= (int64_t)saveg_read8() << 24;
-    result |= (int64_t)saveg_read8() << 32;
-    result |= (int64_t)saveg_read8() << 40;
-    result |= (int64_t)saveg_read8() << 48;
-    result |= (int64_t)saveg_read8() << 56;
+    saveg_get(b, 8);
 
-    return result;
+    for (i = 7 ; i >= 0 ; i--)
+    {
+        result = (result << 8) | b[i];
+    }
+
+    return (int64_t) result;
 }
 
 static void saveg_write64(int64_t value)
 {
-    saveg_write8(value & 0xff);
-    saveg_write8((value >> 8) & 0xff);
-    saveg_write8((value >> 16) & 0xff);
-    saveg_write8((value >> 24) & 0xff);
-    saveg_write8((value >> 32) & 0xff);
-    saveg_write8((value >> 40) & 0xff);
-    saveg_write8((value >> 48) & 0xff);
-    saveg_write8((value >> 56) & 0xff);
+    byte b[8];
+    int i;
+
+    for (i = 0 ; i < 8 ; i++)
+    {
+        b[i] = (value >> (i * 8)) & 0xff;
+    }
+
+    saveg_put(b, 8);
 }
 
 // -----------------------------------------------------------------------------
@@ -509,7 +729,7 @@ static void saveg_read_pad(void)
     int padding;
     int i;
 
-    pos = saveg_ftell();
+    pos = saveg_tell();
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -525,7 +745,7 @@ static void saveg_write_pad(void)
     int padding;
     int i;
 
-    pos = saveg_ftell();
+    pos = saveg_tell();
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -557,6 +777,17 @@ static void saveg_writep(const void *p)
 // Structure read/write functions
 //
 
+// Sizes of the fixed records, as laid out in the savegame.
+
+#define SAVEG_MOBJ_SIZE         154
+#define SAVEG_CEILING_SIZE      48
+#define SAVEG_VLDOOR_SIZE       40
+#define SAVEG_FLOORMOVE_SIZE    42
+#define SAVEG_PLAT_SIZE         56
+#define SAVEG_LIGHTFLASH_SIZE   36
+#define SAVEG_STROBE_SIZE       36
+#define SAVEG_GLOW_SIZE         28
+
 //
 // mapthing_t
 //
@@ -633,6 +864,8 @@ static void saveg_read_mobj_t(mobj_t *str)
 {
     int pl;
 
+    saveg_begin_read(SAVEG_MOBJ_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -747,6 +980,8 @@ static void saveg_read_mobj_t(mobj_t *str)
 
     // struct mobj_s* tracer;
     str->tracer = saveg_readp();
+
+    saveg_end_read();
 }
 
 static void saveg_write_mobj_t(mobj_t *str)
@@ -836,7 +1071,7 @@ static void saveg_write_mobj_t(mobj_t *str)
     saveg_write32(str->movecount);
 
     // struct mobj_s* target;
-    saveg_writep((void *)(uintptr_t) P_ThinkerToIndex((thinker_t *) str->target));
+    saveg_writep((void *)(uintptr_t) saveg_mobj_index(str->target));
 
     // int reactiontime;
     saveg_write32(str->reactiontime);
@@ -861,7 +1096,7 @@ static void saveg_write_mobj_t(mobj_t *str)
     saveg_write_mapthing_t(&str->spawnpoint);
 
     // struct mobj_s* tracer;
-    saveg_writep((void *)(uintptr_t) P_ThinkerToIndex((thinker_t *) str->tracer));
+    saveg_writep((void *)(uintptr_t) saveg_mobj_index(str->tracer));
 }
 
 
@@ -1244,6 +1479,8 @@ static void saveg_read_ceiling_t(ceiling_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_CEILING_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1274,6 +1511,8 @@ static void saveg_read_ceiling_t(ceiling_t *str)
 
     // int olddirection;
     str->olddirection = saveg_read32();
+
+    saveg_end_read();
 }
 
 static void saveg_write_ceiling_t(ceiling_t *str)
@@ -1317,6 +1556,8 @@ static void saveg_read_vldoor_t(vldoor_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_VLDOOR_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1341,6 +1582,8 @@ static void saveg_read_vldoor_t(vldoor_t *str)
 
     // int topcountdown;
     str->topcountdown = saveg_read32();
+
+    saveg_end_read();
 }
 
 static void saveg_write_vldoor_t(vldoor_t *str)
@@ -1378,6 +1621,8 @@ static void saveg_read_floormove_t(floormove_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_FLOORMOVE_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1405,6 +1650,8 @@ static void saveg_read_floormove_t(floormove_t *str)
 
     // fixed_t speed;
     str->speed = saveg_read32();
+
+    saveg_end_read();
 }
 
 static void saveg_write_floormove_t(floormove_t *str)
@@ -1445,6 +1692,8 @@ static void saveg_read_plat_t(plat_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_PLAT_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1481,6 +1730,8 @@ static void saveg_read_plat_t(plat_t *str)
 
     // plattype_e type;
     str->type = saveg_read_enum();
+
+    saveg_end_read();
 }
 
 static void saveg_write_plat_t(plat_t *str)
@@ -1530,6 +1781,8 @@ static void saveg_read_lightflash_t(lightflash_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_LIGHTFLASH_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1551,6 +1804,8 @@ static void saveg_read_lightflash_t(lightflash_t *str)
 
     // int mintime;
     str->mintime = saveg_read32();
+
+    saveg_end_read();
 }
 
 static void saveg_write_lightflash_t(lightflash_t *str)
@@ -1585,6 +1840,8 @@ static void saveg_read_strobe_t(strobe_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_STROBE_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1606,6 +1863,8 @@ static void saveg_read_strobe_t(strobe_t *str)
 
     // int brighttime;
     str->brighttime = saveg_read32();
+
+    saveg_end_read();
 }
 
 static void saveg_write_strobe_t(strobe_t *str)
@@ -1640,6 +1899,8 @@ static void saveg_read_glow_t(glow_t *str)
 {
     int sector;
 
+    saveg_begin_read(SAVEG_GLOW_SIZE);
+
     // thinker_t thinker;
     saveg_read_thinker_t(&str->thinker);
 
@@ -1655,6 +1916,8 @@ static void saveg_read_glow_t(glow_t *str)
 
     // int direction;
     str->direction = saveg_read32();
+
+    saveg_end_read();
 }
 
 static void saveg_write_glow_t(glow_t *str)
@@ -1824,10 +2087,17 @@ void P_ArchiveWorld (void)
     line_t*		li;
     const side_t*		si;
     
+    saveg_begin_write();
+
+    if (saveg_keyframe())
+    {
+        saveg_number_mobjs();
+    }
+
     // do sectors
     for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
     {
-        if (save_memstream != NULL)
+        if (saveg_keyframe())
         {
             saveg_write32(sec->floorheight);
             saveg_write32(sec->ceilingheight);
@@ -1843,6 +2113,13 @@ void P_ArchiveWorld (void)
 	saveg_write16(sec->lightlevel);
 	saveg_write16(sec->special);		// needed?
 	saveg_write16(sec->tag);		// needed?
+
+        // [JN] Keyframes keep the last noise heard, so monsters
+        // wake up the same way after a restore.
+        if (saveg_keyframe())
+        {
+            saveg_write32(saveg_mobj_index(sec->soundtarget));
+        }
     }
 
     
@@ -1859,7 +2136,7 @@ void P_ArchiveWorld (void)
 	    
 	    si = &sides[li->sidenum[j]];
 
-            if (save_memstream != NULL)
+            if (saveg_keyframe())
             {
                 saveg_write32(si->textureoffset);
                 saveg_write32(si->rowoffset);
@@ -1875,6 +2152,8 @@ void P_ArchiveWorld (void)
 	    saveg_write16(si->midtexture);	
 	}
     }
+
+    saveg_end_write();
 }
 
 
@@ -1889,11 +2168,20 @@ void P_UnArchiveWorld (void)
     sector_t*		sec;
     line_t*		li;
     side_t*		si;
+    boolean		wide;
     
+    // [JN] Sector heights are replaced, cached sight checks are stale.
+    P_SightGeometryChanged();
+
+    // Rewind keyframes keep full precision heights and offsets.
+    wide = saveg_keyframe();
+
     // do sectors
     for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
     {
-        if (save_memstream != NULL)
+        saveg_begin_read(wide ? 22 : 14);
+
+        if (wide)
         {
             sec->floorheight = saveg_read32();
             sec->ceilingheight = saveg_read32();
@@ -1911,11 +2199,22 @@ void P_UnArchiveWorld (void)
 	sec->tag = saveg_read16();		// needed?
 	sec->specialdata = 0;
 	sec->soundtarget = 0;
+
+        // Restored to a pointer by P_RestoreTargets.
+        if (wide)
+        {
+            sec->soundtarget = (mobj_t *) (uintptr_t) saveg_read32();
+        }
+
+        saveg_end_read();
     }
     
     // do lines
     for (i=0, li = lines ; i<numlines ; i++,li++)
     {
+        saveg_begin_read(6 + ((li->sidenum[0] != -1) + (li->sidenum[1] != -1))
+                           * (wide ? 14 : 10));
+
 	li->flags = saveg_read16();
 	li->special = saveg_read16();
 	li->tag = saveg_read16();
@@ -1924,7 +2223,7 @@ void P_UnArchiveWorld (void)
 	    if (li->sidenum[j] == -1)
 		continue;
 	    si = &sides[li->sidenum[j]];
-            if (save_memstream != NULL)
+            if (wide)
             {
                 si->textureoffset = saveg_read32();
                 si->rowoffset = saveg_read32();
@@ -1939,6 +2238,8 @@ void P_UnArchiveWorld (void)
 	    si->bottomtexture = saveg_read16();
 	    si->midtexture = saveg_read16();
 	}
+
+        saveg_end_read();
     }
 }
 
@@ -1964,6 +2265,9 @@ void P_ArchiveThinkers (void)
 {
     thinker_t*		th;
 
+    saveg_begin_write();
+    saveg_number_mobjs();
+
     // save off the current thinkers
     for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
     {
@@ -1981,6 +2285,8 @@ void P_ArchiveThinkers (void)
 
     // add a terminating marker
     saveg_write8(tc_end);
+
+    saveg_end_write();
 }
 
 
@@ -2004,7 +2310,7 @@ void P_UnArchiveThinkers (void)
 	if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
 	    P_RemoveMobj ((mobj_t *)currentthinker);
 	else
-	    Z_Free (currentthinker);
+	    P_FreeThinker (currentthinker);
 
 	currentthinker = next;
     }
@@ -2021,11 +2327,12 @@ void P_UnArchiveThinkers (void)
 			
 	  case tc_mobj:
 	    saveg_read_pad();
-	    mobj = Z_Malloc (sizeof(*mobj), PU_LEVEL, NULL);
+	    mobj = P_AllocThinker (sizeof(*mobj));
             saveg_read_mobj_t(mobj);
 
-	    // [JN] Optionally restore monster targets.
-	    if (!crl_restore_targets)
+	    // [JN] Optionally restore monster targets. Rewind and demo
+	    // seek keyframes always keep them, or playback would desync.
+	    if (!crl_restore_targets && !saveg_keyframe())
 	    {
 	        mobj->target = NULL;
 	        mobj->tracer = NULL;
@@ -2081,6 +2388,8 @@ void P_ArchiveSpecials (void)
     thinker_t*		th;
     int			i;
 	
+    saveg_begin_write();
+
     // save off the current thinkers
     for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
     {
@@ -2159,6 +2468,8 @@ void P_ArchiveSpecials (void)
     // add a terminating marker
     saveg_write8(tc_endspecials);
 
+    saveg_end_write();
+
 }
 
 
@@ -2189,7 +2500,7 @@ void P_UnArchiveSpecials (void)
 			
 	  case tc_ceiling:
 	    saveg_read_pad();
-	    ceiling = Z_Malloc (sizeof(*ceiling), PU_LEVEL, NULL);
+	    ceiling = P_AllocThinker (sizeof(*ceiling));
             saveg_read_ceiling_t(ceiling);
 	    ceiling->sector->specialdata = ceiling;
 
@@ -2202,7 +2513,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_door:
 	    saveg_read_pad();
-	    door = Z_Malloc (sizeof(*door), PU_LEVEL, NULL);
+	    door = P_AllocThinker (sizeof(*door));
             saveg_read_vldoor_t(door);
 	    door->sector->specialdata = door;
 	    door->thinker.function.acp1 = (actionf_p1)T_VerticalDoor;
@@ -2211,7 +2522,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_floor:
 	    saveg_read_pad();
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVEL, NULL);
+	    floor = P_AllocThinker (sizeof(*floor));
             saveg_read_floormove_t(floor);
 	    floor->sector->specialdata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -2220,7 +2531,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_plat:
 	    saveg_read_pad();
-	    plat = Z_Malloc (sizeof(*plat), PU_LEVEL, NULL);
+	    plat = P_AllocThinker (sizeof(*plat));
             saveg_read_plat_t(plat);
 	    plat->sector->specialdata = plat;
 
@@ -2233,7 +2544,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_flash:
 	    saveg_read_pad();
-	    flash = Z_Malloc (sizeof(*flash), PU_LEVEL, NULL);
+	    flash = P_AllocThinker (sizeof(*flash));
             saveg_read_lightflash_t(flash);
 	    flash->thinker.function.acp1 = (actionf_p1)T_LightFlash;
 	    P_AddThinker (&flash->thinker);
@@ -2241,7 +2552,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_strobe:
 	    saveg_read_pad();
-	    strobe = Z_Malloc (sizeof(*strobe), PU_LEVEL, NULL);
+	    strobe = P_AllocThinker (sizeof(*strobe));
             saveg_read_strobe_t(strobe);
 	    strobe->thinker.function.acp1 = (actionf_p1)T_StrobeFlash;
 	    P_AddThinker (&strobe->thinker);
@@ -2249,7 +2560,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_glow:
 	    saveg_read_pad();
-	    glow = Z_Malloc (sizeof(*glow), PU_LEVEL, NULL);
+	    glow = P_AllocThinker (sizeof(*glow));
             saveg_read_glow_t(glow);
 	    glow->thinker.function.acp1 = (actionf_p1)T_Glow;
 	    P_AddThinker (&glow->thinker);
@@ -2307,7 +2618,10 @@ uint32_t P_ThinkerToIndex (const thinker_t *thinker)
         return 0;
     }
 
-    for (th = thinkercap.next, i = 1 ; th != &thinkercap ; th = th->next, i++)
+    // [JN] Only map objects are archived, so only they are counted.
+    // Counting every thinker shifted the indices whenever a special
+    // preceded a map object in the list.
+    for (th = thinkercap.next, i = 1 ; th != &thinkercap ; th = th->next)
     {
         if (th->function.acp1 == (actionf_p1) P_MobjThinker)
         {
@@ -2315,6 +2629,7 @@ uint32_t P_ThinkerToIndex (const thinker_t *thinker)
             {
                 return i;
             }
+            i++;
         }
     }
 
@@ -2325,26 +2640,46 @@ uint32_t P_ThinkerToIndex (const thinker_t *thinker)
 // [crispy] replace indizes with corresponding pointers
 // -----------------------------------------------------------------------------
 
-static thinker_t *P_IndexToThinker (uint32_t index)
+// [JN] Map objects in thinker list order, filled in once per restore by
+// P_RestoreTargets, so that each index is looked up directly.
+
+static thinker_t **restoretargets_table;
+static uint32_t restoretargets_len;
+static uint32_t restoretargets_max;
+
+static void P_NumberThinkers (void)
 {
     thinker_t *th;
-    uint32_t   i;
 
-    if (!index)
-    {
-        return NULL;
-    }
+    restoretargets_len = 0;
 
-    for (th = thinkercap.next, i = 1 ; th != &thinkercap ; th = th->next, i++)
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
     {
         if (th->function.acp1 == (actionf_p1) P_MobjThinker)
         {
-            if (i == index)
+            if (restoretargets_len == restoretargets_max)
             {
-                return th;
+                restoretargets_max = restoretargets_max ? restoretargets_max * 2 : 1024;
+                restoretargets_table = I_Realloc(restoretargets_table,
+                                                 restoretargets_max * sizeof(*restoretargets_table));
             }
+
+            restoretargets_table[restoretargets_len++] = th;
         }
     }
+}
+
+static thinker_t *P_IndexToThinker (uint32_t index)
+{
+    if (!index)
+    {
+        return NULL;
+    }
+
+    if (index <= restoretargets_len)
+    {
+        return restoretargets_table[index - 1];
+    }
 
     restoretargets_fail++;
 
@@ -2360,6 +2695,9 @@ void P_RestoreTargets (void)
 {
     mobj_t    *mo;
     thinker_t *th;
+    int        i;
+
+    P_NumberThinkers();
 
     for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
     {
@@ -2371,6 +2709,12 @@ void P_RestoreTargets (void)
         }
     }
 
+    for (i = 0 ; i < numsectors ; i++)
+    {
+        sectors[i].soundtarget =
+            (mobj_t*) P_IndexToThinker((uintptr_t) sectors[i].soundtarget);
+    }
+
     if (restoretargets_fail)
     {
         printf ("P_RestoreTargets: Failed to restore %d target thinkers.\n",
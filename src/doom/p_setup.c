@@ -1030,6 +1030,67 @@ static void P_CheckMapFormat (int lumpnum)
     }
 }
 
+// -----------------------------------------------------------------------------
+// P_BuildSoundGraph
+//  [JN] Builds the sound propagation graph used by P_RecursiveSound.
+//  For every sector, lists two-sided lines leading to other sectors,
+//  keeping the order of sector's lines list, so the flood visits
+//  sectors in exactly the same order as walking the lines would.
+// -----------------------------------------------------------------------------
+
+static void P_BuildSoundGraph (void)
+{
+    soundedge_t *edgebuffer;
+    int totaledges = 0;
+    int i, j;
+
+    for (i = 0 ; i < numsectors ; i++)
+    {
+        for (j = 0 ; j < sectors[i].linecount ; j++)
+        {
+            const line_t *const li = sectors[i].lines[j];
+
+            if ((li->flags & ML_TWOSIDED) && li->sidenum[1] != -1)
+            {
+                totaledges++;
+            }
+        }
+    }
+
+    edgebuffer = Z_Malloc(totaledges * sizeof(*edgebuffer), PU_LEVEL, 0);
+
+    for (i = 0 ; i < numsectors ; i++)
+    {
+        sector_t *const sec = &sectors[i];
+
+        sec->soundedges = edgebuffer;
+        sec->soundedgecount = 0;
+
+        for (j = 0 ; j < sec->linecount ; j++)
+        {
+            const line_t *const li = sec->lines[j];
+            soundedge_t *edge;
+
+            // One-sided lines never pass the sound, and so does
+            // a two-sided line without back side, see P_LineOpening.
+            if (!(li->flags & ML_TWOSIDED) || li->sidenum[1] == -1)
+            {
+                continue;
+            }
+
+            edge = &sec->soundedges[sec->soundedgecount++];
+            edge->front = li->frontsector;
+            edge->back = li->backsector;
+            edge->other = sides[li->sidenum[0]].sector == sec ?
+                          sides[li->sidenum[1]].sector :
+                          sides[li->sidenum[0]].sector;
+            edge->soundblock = (li->flags & ML_SOUNDBLOCK) != 0;
+        }
+
+        edgebuffer += sec->soundedgecount;
+    }
+}
+
 //
 // P_SetupLevel
 //
@@ -1072,8 +1133,12 @@ P_SetupLevel
     Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
 
     // UNUSED W_Profile ();
+    P_InitThinkerPools ();
     P_InitThinkers ();
 
+    // [JN] New level geometry, forget all cached sight checks.
+    P_SightGeometryChanged();
+
     // if working with a devlopment map, reload it
     W_Reload ();
 
@@ -1121,6 +1186,7 @@ P_SetupLevel
     P_LoadSegs (lumpnum+ML_SEGS);
 
     P_GroupLines ();
+    P_BuildSoundGraph ();
     P_LoadReject (lumpnum+ML_REJECT);
 
     bodyqueslot = 0;
@@ -1175,6 +1241,9 @@ P_SetupLevel
     {
         // [JN] Print amount of level loading time.
         printf("loaded in %d ms.\n", SDL_GetTicks() - starttime);
+
+        // [JN] Start thinker profiling from scratch.
+        P_ResetThinkerProfiler();
     }
 
     //printf ("free memory: 0x%x\n", Z_FreeMemory());
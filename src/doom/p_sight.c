@@ -19,10 +19,14 @@
 //
 
 
+#include <string.h>
+
 #include "doomstat.h"
 #include "i_system.h"
 #include "p_local.h"
 
+#include "crlvars.h"
+
 
 //
 // P_CheckSight
@@ -38,6 +42,88 @@ fixed_t		t2y;
 int		sightcounts[2];
 
 
+// -----------------------------------------------------------------------------
+// [JN] Sight check cache.
+//  Result of the BSP traversal depends only on positions and heights
+//  of both actors and on the sector heights, so it is remembered in a
+//  small direct-mapped table and reused while none of these change.
+//  Every entry is stamped with the geometry counter, which is bumped
+//  whenever any sector floor or ceiling may have moved.
+// -----------------------------------------------------------------------------
+
+#define SIGHTCACHESIZE 4096  // Must be a power of two.
+
+typedef struct
+{
+    fixed_t  t1x, t1y, t1z, t1height;
+    fixed_t  t2x, t2y, t2z, t2height;
+    unsigned geometry;     // sightgeometry at the moment of check.
+    boolean  result;
+    fixed_t  topslope;     // Slopes left after traversal,
+    fixed_t  bottomslope;  // restored on cache hit.
+} sightcache_t;
+
+static sightcache_t sightcache[SIGHTCACHESIZE];
+
+// Zero-filled cache entries are never valid, so start from one.
+static unsigned sightgeometry = 1;
+
+//
+// P_SightGeometryChanged
+// Invalidates all cached sight checks.
+//
+void P_SightGeometryChanged (void)
+{
+    if (++sightgeometry == 0)
+    {
+        // Counter wrapped around, clear the table to avoid false hits.
+        memset(sightcache, 0, sizeof(sightcache));
+        sightgeometry = 1;
+    }
+}
+
+static sightcache_t *P_SightCacheEntry (const mobj_t *t1, const mobj_t *t2)
+{
+    unsigned hash;
+
+    hash  = (unsigned)t1->x * 31u + (unsigned)t1->y;
+    hash  = hash * 31u + (unsigned)t1->z;
+    hash  = hash * 31u + (unsigned)t2->x;
+    hash  = hash * 31u + (unsigned)t2->y;
+    hash  = hash * 31u + (unsigned)t2->z;
+    hash ^= hash >> 16;
+
+    return &sightcache[hash & (SIGHTCACHESIZE - 1)];
+}
+
+static boolean P_SightCacheMatch (const sightcache_t *entry,
+                                  const mobj_t *t1, const mobj_t *t2)
+{
+    return entry->geometry == sightgeometry
+        && entry->t1x == t1->x && entry->t1y == t1->y
+        && entry->t1z == t1->z && entry->t1height == t1->height
+        && entry->t2x == t2->x && entry->t2y == t2->y
+        && entry->t2z == t2->z && entry->t2height == t2->height;
+}
+
+static void P_SightCacheStore (sightcache_t *entry, const mobj_t *t1,
+                               const mobj_t *t2, boolean result)
+{
+    entry->t1x = t1->x;
+    entry->t1y = t1->y;
+    entry->t1z = t1->z;
+    entry->t1height = t1->height;
+    entry->t2x = t2->x;
+    entry->t2y = t2->y;
+    entry->t2z = t2->z;
+    entry->t2height = t2->height;
+    entry->geometry = sightgeometry;
+    entry->result = result;
+    entry->topslope = topslope;
+    entry->bottomslope = bottomslope;
+}
+
+
 // PTR_SightTraverse() for Doom 1.2 sight calculations
 // taken from prboom-plus/src/p_sight.c:69-102
 static boolean PTR_SightTraverse(intercept_t *in)
@@ -327,6 +413,37 @@ static boolean P_CrossBSPNode (int bspnum)
 }
 
 
+//
+// P_CheckSightTraverse
+// [JN] Line of sight check itself, split out of P_CheckSight,
+// so its result can be cached.
+//
+static boolean P_CheckSightTraverse (const mobj_t *t1, const mobj_t *t2)
+{
+    validcount++;
+	
+    sightzstart = t1->z + t1->height - (t1->height>>2);
+    topslope = (t2->z+t2->height) - sightzstart;
+    bottomslope = (t2->z) - sightzstart;
+	
+    if (gameversion <= exe_doom_1_2)
+    {
+        return P_PathTraverse(t1->x, t1->y, t2->x, t2->y,
+                              PT_EARLYOUT | PT_ADDLINES, PTR_SightTraverse);
+    }
+
+    strace.x = t1->x;
+    strace.y = t1->y;
+    t2x = t2->x;
+    t2y = t2->y;
+    strace.dx = t2->x - t1->x;
+    strace.dy = t2->y - t1->y;
+
+    // the head node is the last node output
+    return P_CrossBSPNode (numnodes-1);	
+}
+
+
 //
 // P_CheckSight
 // Returns true
@@ -366,27 +483,39 @@ P_CheckSight
     // Now look from eyes of t1 to any part of t2.
     sightcounts[1]++;
 
-    validcount++;
-	
-    sightzstart = t1->z + t1->height - (t1->height>>2);
-    topslope = (t2->z+t2->height) - sightzstart;
-    bottomslope = (t2->z) - sightzstart;
-	
-    if (gameversion <= exe_doom_1_2)
+    // [JN] Doom 1.2 traversal goes through intercepts overflow
+    // emulation having side effects, so it is never cached.
+    if (crl_sight_cache && gameversion > exe_doom_1_2)
     {
-        return P_PathTraverse(t1->x, t1->y, t2->x, t2->y,
-                              PT_EARLYOUT | PT_ADDLINES, PTR_SightTraverse);
-    }
+        sightcache_t *const entry = P_SightCacheEntry(t1, t2);
 
-    strace.x = t1->x;
-    strace.y = t1->y;
-    t2x = t2->x;
-    t2y = t2->y;
-    strace.dx = t2->x - t1->x;
-    strace.dy = t2->y - t1->y;
-
-    // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
-}
+        if (P_SightCacheMatch(entry, t1, t2))
+        {
+            const boolean result = entry->result;
+
+            // Debug mode: repeat full traversal and make sure
+            // cached result is identical, including slopes.
+            if (crl_sight_cache == 2)
+            {
+                const fixed_t cachedtop = entry->topslope;
+                const fixed_t cachedbottom = entry->bottomslope;
+
+                if (P_CheckSightTraverse(t1, t2) != result
+                ||  topslope != cachedtop || bottomslope != cachedbottom)
+                {
+                    I_Error("P_CheckSight: cache mismatch (mobj types %d and %d, gametic %d)",
+                            t1->type, t2->type, gametic);
+                }
+            }
+
+            topslope = entry->topslope;
+            bottomslope = entry->bottomslope;
+            return result;
+        }
 
+        P_SightCacheStore(entry, t1, t2, P_CheckSightTraverse(t1, t2));
+        return entry->result;
+    }
 
+    return P_CheckSightTraverse(t1, t2);
+}
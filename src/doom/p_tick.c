@@ -20,7 +20,14 @@
 //
 
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "z_zone.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_misc.h"
 #include "p_local.h"
 #include "doomstat.h"
 
@@ -37,7 +44,7 @@ int	leveltime;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
+// All thinkers should be allocated by P_AllocThinker
 // so they can be operated on uniformly.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
@@ -49,6 +56,126 @@ int	leveltime;
 thinker_t	thinkercap;
 
 
+// -----------------------------------------------------------------------------
+// [JN] Thinker pools.
+//  Instead of allocating every thinker with its own Z_Malloc call, thinkers
+//  of the same size (which effectively means of the same type) are cut from
+//  big contiguous slabs, and freed ones are kept in a free list for reuse.
+//  Slabs are never moved or shrunk, so thinker addresses stay stable, and
+//  the thinker list itself is left untouched, so iteration order and
+//  P_ThinkerToIndex are exactly the same as before.
+//  Slabs are PU_LEVEL zone blocks and get freed on level change.
+// -----------------------------------------------------------------------------
+
+#define THINKERSLABSIZE 256  // Thinkers per slab.
+#define MAXTHINKERPOOLS 16   // Distinct thinker sizes.
+
+struct thinkerpool_s;
+
+// Header placed in front of each thinker.
+typedef union thinkerslot_u
+{
+    struct
+    {
+        struct thinkerpool_s *pool;      // Owner pool.
+        union thinkerslot_u  *nextfree;  // Free list link.
+    } s;
+    uint64_t align;  // Keep thinker data 8-byte aligned.
+} thinkerslot_t;
+
+typedef struct thinkerpool_s
+{
+    size_t         size;      // Size of thinker structure.
+    size_t         stride;    // Size of slot, header included.
+    thinkerslot_t *freelist;  // Freed slots, most recent first.
+    byte          *slab;      // Current slab,
+    int            slabused;  // and number of slots taken from it.
+} thinkerpool_t;
+
+static thinkerpool_t thinkerpools[MAXTHINKERPOOLS];
+static int numthinkerpools;
+
+//
+// P_InitThinkerPools
+// Forgets all pools. Must be called after PU_LEVEL blocks are freed.
+//
+void P_InitThinkerPools (void)
+{
+    memset(thinkerpools, 0, sizeof(thinkerpools));
+    numthinkerpools = 0;
+}
+
+static thinkerpool_t *P_GetThinkerPool (size_t size)
+{
+    thinkerpool_t *pool;
+    int i;
+
+    for (i = 0 ; i < numthinkerpools ; i++)
+    {
+        if (thinkerpools[i].size == size)
+        {
+            return &thinkerpools[i];
+        }
+    }
+
+    if (numthinkerpools == MAXTHINKERPOOLS)
+    {
+        I_Error("P_GetThinkerPool: too many thinker sizes");
+    }
+
+    pool = &thinkerpools[numthinkerpools++];
+    pool->size = size;
+    pool->stride = sizeof(thinkerslot_t) + ((size + 7) & ~(size_t)7);
+    pool->slabused = THINKERSLABSIZE;  // Force allocation of first slab.
+
+    return pool;
+}
+
+//
+// P_AllocThinker
+// Returns uninitialized memory for a thinker of given size,
+// same as Z_Malloc would do.
+//
+void *P_AllocThinker (size_t size)
+{
+    thinkerpool_t *const pool = P_GetThinkerPool(size);
+    thinkerslot_t *slot;
+
+    if (pool->freelist)
+    {
+        slot = pool->freelist;
+        pool->freelist = slot->s.nextfree;
+    }
+    else
+    {
+        if (pool->slabused == THINKERSLABSIZE)
+        {
+            pool->slab = Z_Malloc(pool->stride * THINKERSLABSIZE, PU_LEVEL, NULL);
+            pool->slabused = 0;
+        }
+
+        slot = (thinkerslot_t *)(pool->slab + pool->stride * pool->slabused++);
+    }
+
+    slot->s.pool = pool;
+
+    return slot + 1;
+}
+
+//
+// P_FreeThinker
+// Returns thinker's memory to its pool.
+//
+void P_FreeThinker (thinker_t *thinker)
+{
+    thinkerslot_t *const slot = (thinkerslot_t *)thinker - 1;
+    thinkerpool_t *const pool = slot->s.pool;
+
+    slot->s.nextfree = pool->freelist;
+    pool->freelist = slot;
+}
+
+
 //
 // P_InitThinkers
 //
@@ -99,6 +226,265 @@ void P_AllocateThinker (thinker_t*	thinker)
 
 
 
+// =============================================================================
+//
+//                              Thinker profiler
+//
+// =============================================================================
+
+// [JN] Time and calls are bucketed per thinker function, and additionally
+// per mobj type for P_MobjThinker. Three sets of counters are kept:
+// the current one-second window, a snapshot of the last finished window
+// (used by the widget) and the totals of the whole level (used by dump).
+
+const char *thinkerprof_names[NUMTHINKERPROFS] =
+{
+    "MOBJ", "CEILING", "DOOR", "FLOOR", "PLAT",
+    "FLASH", "STROBE", "GLOW", "FLICKER", "OTHER", "REMOVE",
+};
+
+thinkerprof_t thinkerprof[NUMTHINKERPROFS];
+thinkerprof_t thinkerprof_mobj[NUMMOBJTYPES];
+int           thinkerprof_tics;
+
+static thinkerprof_t prof_window[NUMTHINKERPROFS];
+static thinkerprof_t prof_window_mobj[NUMMOBJTYPES];
+static int           prof_window_tics;
+
+static thinkerprof_t prof_level[NUMTHINKERPROFS];
+static thinkerprof_t prof_level_mobj[NUMMOBJTYPES];
+static int           prof_level_tics;
+
+// File given by -thinkerdump, NULL if not used.
+char *thinkerdump_file = NULL;
+
+//
+// P_ResetThinkerProfiler
+// Clears all counters, called on every level start.
+//
+void P_ResetThinkerProfiler (void)
+{
+    memset(thinkerprof, 0, sizeof(thinkerprof));
+    memset(thinkerprof_mobj, 0, sizeof(thinkerprof_mobj));
+    memset(prof_window, 0, sizeof(prof_window));
+    memset(prof_window_mobj, 0, sizeof(prof_window_mobj));
+    memset(prof_level, 0, sizeof(prof_level));
+    memset(prof_level_mobj, 0, sizeof(prof_level_mobj));
+    thinkerprof_tics = prof_window_tics = prof_level_tics = 0;
+}
+
+static int P_ThinkerProfIndex (const thinker_t *thinker)
+{
+    const actionf_p1 func = thinker->function.acp1;
+
+    if (func == (actionf_p1) P_MobjThinker)  return tp_mobj;
+    if (func == (actionf_p1) T_MoveCeiling)  return tp_ceiling;
+    if (func == (actionf_p1) T_VerticalDoor) return tp_door;
+    if (func == (actionf_p1) T_MoveFloor)    return tp_floor;
+    if (func == (actionf_p1) T_PlatRaise)    return tp_plat;
+    if (func == (actionf_p1) T_LightFlash)   return tp_flash;
+    if (func == (actionf_p1) T_StrobeFlash)  return tp_strobe;
+    if (func == (actionf_p1) T_Glow)         return tp_glow;
+    if (func == (actionf_p1) T_FireFlicker)  return tp_flicker;
+
+    return tp_other;
+}
+
+static void P_ThinkerProfAdd (int index, int type, uint64_t time)
+{
+    prof_window[index].time += time;
+    prof_window[index].calls++;
+    prof_level[index].time += time;
+    prof_level[index].calls++;
+
+    if (index == tp_mobj)
+    {
+        prof_window_mobj[type].time += time;
+        prof_window_mobj[type].calls++;
+        prof_level_mobj[type].time += time;
+        prof_level_mobj[type].calls++;
+    }
+}
+
+//
+// P_RunThinkersProfiled
+// Same as P_RunThinkers, but measures every thinker call.
+//
+static void P_RunThinkersProfiled (void)
+{
+    thinker_t *currentthinker, *nextthinker;
+    uint64_t start;
+
+    currentthinker = thinkercap.next;
+    while (currentthinker != &thinkercap)
+    {
+        // [JN] CRL - do not run other than player thinkers in freeze mode.
+        if (crl_freeze)
+        {
+            const mobj_t *mo = (mobj_t *)currentthinker;
+
+            if (mo->type != MT_PLAYER || currentthinker->function.acp1 != (actionf_p1) P_MobjThinker)
+            {
+                currentthinker = currentthinker->next;
+                continue;
+            }
+        }
+
+        if (currentthinker->function.acv == (actionf_v)(-1))
+        {
+            // time to remove it
+            start = I_GetPerfCounter();
+            nextthinker = currentthinker->next;
+            currentthinker->next->prev = currentthinker->prev;
+            currentthinker->prev->next = currentthinker->next;
+            P_FreeThinker(currentthinker);
+            P_ThinkerProfAdd(tp_remove, 0, I_GetPerfCounter() - start);
+        }
+        else
+        {
+            if (currentthinker->function.acp1)
+            {
+                const int index = P_ThinkerProfIndex(currentthinker);
+                // Remember the type now, the mobj may be removed by its thinker.
+                const int type = index == tp_mobj ? ((mobj_t *)currentthinker)->type : 0;
+
+                start = I_GetPerfCounter();
+                currentthinker->function.acp1 (currentthinker);
+                P_ThinkerProfAdd(index, type, I_GetPerfCounter() - start);
+            }
+
+            nextthinker = currentthinker->next;
+        }
+        currentthinker = nextthinker;
+    }
+
+    prof_level_tics++;
+
+    // Once per second, publish the window for the widget.
+    if (++prof_window_tics >= TICRATE)
+    {
+        memcpy(thinkerprof, prof_window, sizeof(thinkerprof));
+        memcpy(thinkerprof_mobj, prof_window_mobj, sizeof(thinkerprof_mobj));
+        thinkerprof_tics = prof_window_tics;
+        memset(prof_window, 0, sizeof(prof_window));
+        memset(prof_window_mobj, 0, sizeof(prof_window_mobj));
+        prof_window_tics = 0;
+    }
+}
+
+static void P_PrintThinkerProf (FILE *stream, const char *name,
+                                const thinkerprof_t *stat, double freq)
+{
+    const double ms = (double)stat->time * 1000.0 / freq;
+
+    fprintf(stream, "%-24s %10d %12.3f %10.4f %10.3f\n", name, stat->calls, ms,
+            ms / prof_level_tics,
+            stat->calls ? ms * 1000.0 / stat->calls : 0.0);
+}
+
+static int P_CompareMobjProf (const void *a, const void *b)
+{
+    const uint64_t ta = prof_level_mobj[*(const int *)a].time;
+    const uint64_t tb = prof_level_mobj[*(const int *)b].time;
+
+    return (ta < tb) - (ta > tb);
+}
+
+//
+// P_DumpThinkerProfiler
+// Appends the level totals to the -thinkerdump file. Called on level exit.
+//
+void P_DumpThinkerProfiler (void)
+{
+    static boolean first_dump = true;
+    const double freq = (double)I_GetPerfFrequency();
+    int order[NUMMOBJTYPES];
+    uint64_t total = 0;
+    FILE *stream;
+    char name[32];
+    int i;
+
+    if (thinkerdump_file == NULL || prof_level_tics == 0)
+    {
+        return;
+    }
+
+    // Allow "-" as output file, for stdout.
+    if (strcmp(thinkerdump_file, "-") != 0)
+    {
+        stream = M_fopen(thinkerdump_file, first_dump ? "w" : "a");
+
+        if (stream == NULL)
+        {
+            fprintf(stderr, "P_DumpThinkerProfiler: failed to open %s\n",
+                    thinkerdump_file);
+            return;
+        }
+    }
+    else
+    {
+        stream = stdout;
+    }
+
+    first_dump = false;
+
+    for (i = 0 ; i < NUMTHINKERPROFS ; i++)
+    {
+        total += prof_level[i].time;
+    }
+
+    if (gamemode == commercial)
+    {
+        fprintf(stream, "===== MAP%02d", gamemap);
+    }
+    else
+    {
+        fprintf(stream, "===== E%dM%d", gameepisode, gamemap);
+    }
+    fprintf(stream, ": %d tics, %.3f ms total =====\n\n", prof_level_tics,
+            (double)total * 1000.0 / freq);
+
+    fprintf(stream, "%-24s %10s %12s %10s %10s\n",
+            "Thinker", "Calls", "Total ms", "ms/tic", "us/call");
+
+    for (i = 0 ; i < NUMTHINKERPROFS ; i++)
+    {
+        if (prof_level[i].calls)
+        {
+            P_PrintThinkerProf(stream, thinkerprof_names[i], &prof_level[i], freq);
+        }
+    }
+
+    fprintf(stream, "\n%-24s %10s %12s %10s %10s\n",
+            "Mobj type (doomednum)", "Calls", "Total ms", "ms/tic", "us/call");
+
+    for (i = 0 ; i < NUMMOBJTYPES ; i++)
+    {
+        order[i] = i;
+    }
+    qsort(order, NUMMOBJTYPES, sizeof(*order), P_CompareMobjProf);
+
+    for (i = 0 ; i < NUMMOBJTYPES ; i++)
+    {
+        const int type = order[i];
+
+        if (!prof_level_mobj[type].calls)
+        {
+            continue;
+        }
+
+        M_snprintf(name, sizeof(name), "%d (%d)", type, mobjinfo[type].doomednum);
+        P_PrintThinkerProf(stream, name, &prof_level_mobj[type], freq);
+    }
+
+    fprintf(stream, "\n");
+
+    if (stream != stdout)
+    {
+        fclose(stream);
+    }
+}
+
 //
 // P_RunThinkers
 //
@@ -106,6 +492,13 @@ static void P_RunThinkers (void)
 {
     thinker_t *currentthinker, *nextthinker;
 
+    // [JN] Take the measured path only if the profiler is needed.
+    if (crl_widget_thinkers || thinkerdump_file)
+    {
+        P_RunThinkersProfiled();
+        return;
+    }
+
     currentthinker = thinkercap.next;
     while (currentthinker != &thinkercap)
     {
@@ -126,7 +519,7 @@ static void P_RunThinkers (void)
             nextthinker = currentthinker->next;
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
-	    Z_Free(currentthinker);
+	    P_FreeThinker(currentthinker);
 	}
 	else
 	{
@@ -62,6 +62,9 @@ typedef struct
 // Forward of LineDefs, for Sectors.
 struct line_s;
 
+// [JN] Forward of sound propagation graph edges, for Sectors.
+struct soundedge_s;
+
 // Each sector has a degenmobj_t in its center for sound origin purposes.
 // I suppose this does not handle sound from moving objects (doppler),
 // because position is prolly just buffered, not updated.
@@ -111,6 +114,11 @@ typedef	struct
     int     linecount;
     struct line_s **lines;  // linecount size
 
+    // [JN] Sound propagation graph: two-sided lines leading to
+    // neighbour sectors, in the same order as in lines list.
+    int     soundedgecount;
+    struct soundedge_s *soundedges;  // soundedgecount size
+
     // [AM] Previous position of floor and ceiling before
     //      think.  Used to interpolate between positions.
     fixed_t	oldfloorheight;
@@ -209,6 +217,20 @@ typedef struct line_s
     int sndprop_tics;
 } line_t;
 
+//
+// [JN] Edge of sound propagation graph, built once per level.
+// Only the opening of the line has to be checked while
+// propagating, everything else is precomputed.
+//
+
+typedef struct soundedge_s
+{
+    sector_t *front;       // Sectors of the line, for opening check.
+    sector_t *back;
+    sector_t *other;       // Sector on the other side of the line.
+    boolean   soundblock;  // ML_SOUNDBLOCK is set.
+} soundedge_t;
+
 //
 // A SubSector.
 // References a Sector. Basically, this is a list of LineSegs, indicating 
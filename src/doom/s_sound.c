@@ -285,6 +285,45 @@ void S_StopAllSound(void)
     }
 }
 
+//
+// S_LevelMusic
+// [JN] Music number for the given level.
+//
+
+static int S_LevelMusic(int episode, int map)
+{
+    if (gamemode == commercial)
+    {
+        return mus_runnin + map - 1;
+    }
+    else
+    {
+        const int spmus[]=
+        {
+            // Song - Who? - Where?
+
+            mus_e3m4,        // American     e4m1
+            mus_e3m2,        // Romero       e4m2
+            mus_e3m3,        // Shawn        e4m3
+            mus_e1m5,        // American     e4m4
+            mus_e2m7,        // Tim          e4m5
+            mus_e2m4,        // Romero       e4m6
+            mus_e2m6,        // J.Anderson   e4m7 CHIRON.WAD
+            mus_e2m5,        // Shawn        e4m8
+            mus_e1m9,        // Tim          e4m9
+        };
+
+        if (episode < 4)
+        {
+            return mus_e1m1 + (episode-1)*9 + map-1;
+        }
+        else
+        {
+            return spmus[map-1];
+        }
+    }
+}
+
 //
 // Per level startup code.
 // Kills playing sounds at start of level,
@@ -294,7 +333,6 @@ void S_StopAllSound(void)
 void S_Start(void)
 {
     int cnum;
-    int mnum;
 
     // kill all playing sounds at start of level
     //  (trust me - a good idea)
@@ -309,38 +347,48 @@ void S_Start(void)
     // start new music for the level
     mus_paused = 0;
 
-    if (gamemode == commercial)
+    S_ChangeMusic(S_LevelMusic(gameepisode, gamemap), true);
+}
+
+//
+// S_PrefetchLevelMusic
+// [JN] Lets the music backend read in the given level's track ahead of
+// time, e.g. during the intermission before it.
+//
+
+void S_PrefetchLevelMusic(int episode, int map)
+{
+    const int musicnum = S_LevelMusic(episode, map);
+    musicinfo_t *music;
+    char namebuf[9];
+
+    if (((nodrawers && !I_SoundSinkActive()) || demowarp) && !demo_gotonextlvl)
     {
-        mnum = mus_runnin + gamemap - 1;
+        return;
     }
-    else
+
+    if (musicnum <= mus_None || musicnum >= NUMMUSIC)
     {
-        const int spmus[]=
-        {
-            // Song - Who? - Where?
+        return;
+    }
 
-            mus_e3m4,        // American     e4m1
-            mus_e3m2,        // Romero       e4m2
-            mus_e3m3,        // Shawn        e4m3
-            mus_e1m5,        // American     e4m4
-            mus_e2m7,        // Tim          e4m5
-            mus_e2m4,        // Romero       e4m6
-            mus_e2m6,        // J.Anderson   e4m7 CHIRON.WAD
-            mus_e2m5,        // Shawn        e4m8
-            mus_e1m9,        // Tim          e4m9
-        };
+    music = &S_music[musicnum];
 
-        if (gameepisode < 4)
-        {
-            mnum = mus_e1m1 + (gameepisode-1)*9 + gamemap-1;
-        }
-        else
+    if (!music->lumpnum)
+    {
+        M_snprintf(namebuf, sizeof(namebuf), "d_%s", DEH_String(music->name));
+        music->lumpnum = W_CheckNumForName(namebuf);
+
+        if (music->lumpnum < 0)
         {
-            mnum = spmus[gamemap-1];
+            music->lumpnum = 0;
+            return;
         }
     }
 
-    S_ChangeMusic(mnum, true);
+    I_PrefetchSong(W_CacheLumpNum(music->lumpnum, PU_STATIC),
+                   W_LumpLength(music->lumpnum));
+    W_ReleaseLumpNum(music->lumpnum);
 }
 
 void S_StopSound(const mobj_t *origin)
@@ -536,7 +584,8 @@ void S_StartSound(void *origin_p, int sfx_id)
     int volume;
 
     // [JN] Do not play sound while demo-warp or when SFX volume set to zero.
-    if (nodrawers || demowarp || !snd_SfxVolume)
+    // With -soundsink, sound is kept running under -nodraw.
+    if ((nodrawers && !I_SoundSinkActive()) || demowarp || !snd_SfxVolume)
     {
         return;
     }
@@ -777,7 +826,7 @@ void S_ChangeMusic(int musicnum, int looping)
 
     // [JN] Do not play music while demo-warp,
     // but still change while fast forwarding to next level in demo playback.
-    if ((nodrawers || demowarp) && !demo_gotonextlvl)
+    if (((nodrawers && !I_SoundSinkActive()) || demowarp) && !demo_gotonextlvl)
     {
         return;
     }
@@ -47,6 +47,7 @@ void S_Shutdown(void);
 //
 
 void S_Start(void);
+void S_PrefetchLevelMusic(int episode, int map);
 
 //
 // Start sound for thing at <origin>
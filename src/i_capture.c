@@ -0,0 +1,604 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Lossless gameplay capture of the native 8-bit screen buffer.
+//
+//	The game thread only copies every presented frame into a small
+//	queue. A writer thread stores palette changes and frames, each
+//	frame XORed against the previous one, run-length encoded and
+//	deflated, with a full keyframe once in a while:
+//
+//	  header:  "CRLCAP1\0", width (16), height (16)
+//	  chunk:   type (8), time in ms (32), length (32), payload
+//
+//	  'P'  palette, 256 RGB triplets
+//	  'K'  keyframe, deflated pixels
+//	  'D'  delta, deflated runs of [skip (16), count (16), XOR bytes]
+//	  'S'  frame identical to the previous one, no payload
+//
+//	All values are little endian.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+#include "miniz.h"
+
+#include "i_capture.h"
+#include "i_system.h"
+#include "i_video.h"
+#include "m_misc.h"
+
+
+#define CAPTURE_MAGIC       "CRLCAP1"
+#define CAPTURE_QUEUE       16
+#define CAPTURE_KEYFRAME    256
+#define CAPTURE_PALSIZE     (256 * 3)
+
+// Worst case of the run encoding: alternating changed and equal pixels.
+#define CAPTURE_RLESIZE     (SCREENAREA / 2 * 5 + 8)
+
+typedef struct
+{
+    pixel_t pixels[SCREENAREA];
+    byte palette[CAPTURE_PALSIZE];
+    uint32_t time;
+} captureframe_t;
+
+boolean capture_active = false;
+
+static FILE *capture_file;
+static char *capture_name;
+static uint32_t capture_start;
+static int capture_frames;
+static boolean capture_error;
+
+static SDL_Thread *capture_thread;
+static SDL_mutex *capture_lock;
+static SDL_cond *capture_nonempty;
+static SDL_cond *capture_nonfull;
+static boolean capture_stopping;
+
+static captureframe_t *capture_queue;
+static int capture_head, capture_tail, capture_count;
+
+// Writer thread state.
+static pixel_t *prev_frame;
+static byte *delta_buf;
+static byte *comp_buf;
+static size_t comp_size;
+static byte last_palette[CAPTURE_PALSIZE];
+static boolean have_palette;
+
+static void Put16 (byte *p, unsigned int v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void Put32 (byte *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static unsigned int Get16 (const byte *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t Get32 (const byte *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void WriteChunk (byte type, uint32_t time, const byte *data, size_t len)
+{
+    byte header[9];
+
+    if (capture_error)
+    {
+        return;
+    }
+
+    header[0] = type;
+    Put32(header + 1, time);
+    Put32(header + 5, (uint32_t) len);
+
+    if (fwrite(header, 1, sizeof(header), capture_file) != sizeof(header)
+    || (len > 0 && fwrite(data, 1, len, capture_file) != len))
+    {
+        fprintf(stderr, "I_Capture: Error writing to %s\n", capture_name);
+        capture_error = true;
+    }
+}
+
+static void WriteDeflated (byte type, uint32_t time, const byte *data,
+                           size_t len)
+{
+    mz_ulong out_len = comp_size;
+
+    if (mz_compress2(comp_buf, &out_len, data, len, MZ_BEST_SPEED) != MZ_OK)
+    {
+        fprintf(stderr, "I_Capture: Compression failed\n");
+        capture_error = true;
+        return;
+    }
+
+    WriteChunk(type, time, comp_buf, out_len);
+}
+
+//
+// EncodeDelta
+//  Encodes the XOR of the frame against the previous one as runs of
+//  unchanged and changed pixels. Returns 0 if nothing changed.
+//
+
+static size_t EncodeDelta (const pixel_t *frame)
+{
+    size_t out = 0;
+    int pos = 0;
+
+    while (pos < SCREENAREA)
+    {
+        int skip = 0, count = 0;
+
+        while (pos + skip < SCREENAREA && skip < 0xffff
+            && frame[pos + skip] == prev_frame[pos + skip])
+        {
+            skip++;
+        }
+
+        if (pos + skip == SCREENAREA)
+        {
+            break;
+        }
+
+        pos += skip;
+
+        while (pos + count < SCREENAREA && count < 0xffff
+            && frame[pos + count] != prev_frame[pos + count])
+        {
+            delta_buf[out + 4 + count] = frame[pos + count] ^ prev_frame[pos + count];
+            count++;
+        }
+
+        Put16(delta_buf + out, skip);
+        Put16(delta_buf + out + 2, count);
+        out += 4 + count;
+        pos += count;
+    }
+
+    return out;
+}
+
+static void EncodeFrame (const captureframe_t *frame)
+{
+    if (!have_palette || memcmp(last_palette, frame->palette, CAPTURE_PALSIZE))
+    {
+        memcpy(last_palette, frame->palette, CAPTURE_PALSIZE);
+        have_palette = true;
+        WriteChunk('P', frame->time, last_palette, CAPTURE_PALSIZE);
+    }
+
+    if (capture_frames % CAPTURE_KEYFRAME == 0)
+    {
+        WriteDeflated('K', frame->time, frame->pixels, SCREENAREA);
+    }
+    else
+    {
+        const size_t len = EncodeDelta(frame->pixels);
+
+        if (len == 0)
+        {
+            WriteChunk('S', frame->time, NULL, 0);
+        }
+        else
+        {
+            WriteDeflated('D', frame->time, delta_buf, len);
+        }
+    }
+
+    memcpy(prev_frame, frame->pixels, SCREENAREA);
+    capture_frames++;
+}
+
+static int CaptureThread (void *unused)
+{
+    while (1)
+    {
+        const captureframe_t *frame;
+
+        SDL_LockMutex(capture_lock);
+
+        while (capture_count == 0 && !capture_stopping)
+        {
+            SDL_CondWait(capture_nonempty, capture_lock);
+        }
+
+        if (capture_count == 0)
+        {
+            SDL_UnlockMutex(capture_lock);
+            break;
+        }
+
+        frame = &capture_queue[capture_tail];
+        SDL_UnlockMutex(capture_lock);
+
+        // The slot stays owned by this thread until it is released below.
+        EncodeFrame(frame);
+
+        SDL_LockMutex(capture_lock);
+        capture_tail = (capture_tail + 1) % CAPTURE_QUEUE;
+        capture_count--;
+        SDL_CondSignal(capture_nonfull);
+        SDL_UnlockMutex(capture_lock);
+    }
+
+    return 0;
+}
+
+//
+// I_StartCapture
+//  Opens the capture file and starts the writer thread.
+//
+
+void I_StartCapture (const char *filename)
+{
+    byte header[12];
+
+    if (capture_active)
+    {
+        return;
+    }
+
+    capture_file = M_fopen(filename, "wb");
+
+    if (capture_file == NULL)
+    {
+        fprintf(stderr, "I_StartCapture: Unable to open %s\n", filename);
+        return;
+    }
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    Put16(header + 8, SCREENWIDTH);
+    Put16(header + 10, SCREENHEIGHT);
+    fwrite(header, 1, sizeof(header), capture_file);
+
+    capture_name = M_StringDuplicate(filename);
+    capture_queue = malloc(CAPTURE_QUEUE * sizeof(*capture_queue));
+    prev_frame = calloc(1, SCREENAREA);
+    delta_buf = malloc(CAPTURE_RLESIZE);
+    comp_size = mz_compressBound(CAPTURE_RLESIZE);
+    comp_buf = malloc(comp_size);
+
+    if (capture_queue == NULL || prev_frame == NULL
+    ||  delta_buf == NULL || comp_buf == NULL)
+    {
+        I_Error("I_StartCapture: Out of memory");
+    }
+
+    capture_head = capture_tail = capture_count = 0;
+    capture_frames = 0;
+    capture_error = false;
+    capture_stopping = false;
+    have_palette = false;
+
+    capture_lock = SDL_CreateMutex();
+    capture_nonempty = SDL_CreateCond();
+    capture_nonfull = SDL_CreateCond();
+    capture_thread = SDL_CreateThread(CaptureThread, "capture", NULL);
+
+    if (capture_thread == NULL)
+    {
+        I_Error("I_StartCapture: Unable to create writer thread: %s",
+                SDL_GetError());
+    }
+
+    capture_start = SDL_GetTicks();
+    capture_active = true;
+
+    I_AtExit(I_StopCapture, true);
+
+    printf("I_StartCapture: Capturing to %s\n", filename);
+}
+
+//
+// I_StopCapture
+//  Writes out the queued frames and closes the capture file.
+//
+
+void I_StopCapture (void)
+{
+    if (!capture_active)
+    {
+        return;
+    }
+
+    capture_active = false;
+
+    SDL_LockMutex(capture_lock);
+    capture_stopping = true;
+    SDL_CondSignal(capture_nonempty);
+    SDL_UnlockMutex(capture_lock);
+
+    SDL_WaitThread(capture_thread, NULL);
+    SDL_DestroyCond(capture_nonfull);
+    SDL_DestroyCond(capture_nonempty);
+    SDL_DestroyMutex(capture_lock);
+
+    fclose(capture_file);
+
+    printf("I_StopCapture: %d frames written to %s\n",
+           capture_frames, capture_name);
+
+    free(capture_queue);
+    free(prev_frame);
+    free(delta_buf);
+    free(comp_buf);
+    free(capture_name);
+}
+
+//
+// I_CaptureFrame
+//  Queues a copy of the presented frame. Blocks only if the writer
+//  falls a whole queue behind, no frame is ever dropped.
+//
+
+void I_CaptureFrame (const pixel_t *pixels, const byte *palette)
+{
+    captureframe_t *frame;
+
+    SDL_LockMutex(capture_lock);
+
+    while (capture_count == CAPTURE_QUEUE)
+    {
+        SDL_CondWait(capture_nonfull, capture_lock);
+    }
+
+    frame = &capture_queue[capture_head];
+    SDL_UnlockMutex(capture_lock);
+
+    // Only the game thread fills free slots, safe to copy unlocked.
+    memcpy(frame->pixels, pixels, SCREENAREA);
+    memcpy(frame->palette, palette, CAPTURE_PALSIZE);
+    frame->time = SDL_GetTicks() - capture_start;
+
+    SDL_LockMutex(capture_lock);
+    capture_head = (capture_head + 1) % CAPTURE_QUEUE;
+    capture_count++;
+    SDL_CondSignal(capture_nonempty);
+    SDL_UnlockMutex(capture_lock);
+}
+
+// -----------------------------------------------------------------------------
+// Exporter
+// -----------------------------------------------------------------------------
+
+static boolean ExportPNG (const char *outdir, int num, const pixel_t *frame,
+                          const byte *palette, byte *rgb)
+{
+    char name[32];
+    char *path;
+    void *png;
+    size_t png_size = 0;
+    FILE *handle;
+    int i;
+
+    for (i = 0 ; i < SCREENAREA ; i++)
+    {
+        memcpy(rgb + i * 3, palette + frame[i] * 3, 3);
+    }
+
+    png = tdefl_write_image_to_png_file_in_memory_ex(rgb, SCREENWIDTH,
+                                                     SCREENHEIGHT, 3,
+                                                     &png_size,
+                                                     MZ_DEFAULT_LEVEL,
+                                                     MZ_FALSE);
+    if (png == NULL)
+    {
+        return false;
+    }
+
+    M_snprintf(name, sizeof(name), "frame%06d.png", num);
+    path = M_StringJoin(outdir, DIR_SEPARATOR_S, name, NULL);
+    handle = M_fopen(path, "wb");
+    free(path);
+
+    if (handle == NULL)
+    {
+        mz_free(png);
+        return false;
+    }
+
+    fwrite(png, 1, png_size, handle);
+    fclose(handle);
+    mz_free(png);
+
+    return true;
+}
+
+static boolean ApplyDelta (pixel_t *frame, const byte *data, size_t len)
+{
+    size_t in = 0;
+    int pos = 0;
+
+    while (in + 4 <= len)
+    {
+        const unsigned int skip = Get16(data + in);
+        const unsigned int count = Get16(data + in + 2);
+        unsigned int i;
+
+        in += 4;
+        pos += skip;
+
+        if (pos + count > SCREENAREA || in + count > len)
+        {
+            return false;
+        }
+
+        for (i = 0 ; i < count ; i++)
+        {
+            frame[pos++] ^= data[in++];
+        }
+    }
+
+    return in == len;
+}
+
+//
+// I_CaptureExport
+//  Decodes a capture file and writes every frame as a PNG file into
+//  outdir, numbered from frame000000.png.
+//
+
+boolean I_CaptureExport (const char *filename, const char *outdir)
+{
+    FILE *handle;
+    byte header[12];
+    byte palette[CAPTURE_PALSIZE];
+    pixel_t *frame;
+    byte *rgb, *chunk, *rle;
+    uint32_t first = 0, last = 0;
+    int frames = 0;
+    boolean ok = true;
+
+    handle = M_fopen(filename, "rb");
+
+    if (handle == NULL)
+    {
+        fprintf(stderr, "I_CaptureExport: Unable to open %s\n", filename);
+        return false;
+    }
+
+    if (fread(header, 1, sizeof(header), handle) != sizeof(header)
+    ||  memcmp(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0
+    ||  Get16(header + 8) != SCREENWIDTH
+    ||  Get16(header + 10) != SCREENHEIGHT)
+    {
+        fprintf(stderr, "I_CaptureExport: %s is not a capture file\n", filename);
+        fclose(handle);
+        return false;
+    }
+
+    M_MakeDirectory(outdir);
+
+    memset(palette, 0, sizeof(palette));
+    frame = calloc(1, SCREENAREA);
+    rgb = malloc(SCREENAREA * 3);
+    rle = malloc(CAPTURE_RLESIZE);
+    chunk = malloc(mz_compressBound(CAPTURE_RLESIZE));
+
+    while (ok)
+    {
+        byte chead[9];
+        uint32_t time, len;
+        mz_ulong out_len;
+
+        if (fread(chead, 1, sizeof(chead), handle) != sizeof(chead))
+        {
+            break;
+        }
+
+        time = Get32(chead + 1);
+        len = Get32(chead + 5);
+
+        if (len > mz_compressBound(CAPTURE_RLESIZE)
+        ||  fread(chunk, 1, len, handle) != len)
+        {
+            ok = false;
+            break;
+        }
+
+        switch (chead[0])
+        {
+            case 'P':
+                if (len != CAPTURE_PALSIZE)
+                {
+                    ok = false;
+                    break;
+                }
+                memcpy(palette, chunk, CAPTURE_PALSIZE);
+                continue;
+
+            case 'K':
+                out_len = SCREENAREA;
+                ok = mz_uncompress(frame, &out_len, chunk, len) == MZ_OK
+                  && out_len == SCREENAREA;
+                break;
+
+            case 'D':
+                out_len = CAPTURE_RLESIZE;
+                ok = mz_uncompress(rle, &out_len, chunk, len) == MZ_OK
+                  && ApplyDelta(frame, rle, out_len);
+                break;
+
+            case 'S':
+                break;
+
+            default:
+                ok = false;
+                break;
+        }
+
+        if (!ok)
+        {
+            break;
+        }
+
+        if (frames == 0)
+        {
+            first = time;
+        }
+        last = time;
+
+        if (!ExportPNG(outdir, frames, frame, palette, rgb))
+        {
+            fprintf(stderr, "I_CaptureExport: Unable to write frame %d\n",
+                    frames);
+            ok = false;
+            break;
+        }
+
+        frames++;
+    }
+
+    fclose(handle);
+    free(frame);
+    free(rgb);
+    free(rle);
+    free(chunk);
+
+    if (!ok)
+    {
+        fprintf(stderr, "I_CaptureExport: %s is damaged after frame %d\n",
+                filename, frames);
+    }
+
+    printf("I_CaptureExport: %d frames exported to %s", frames, outdir);
+    if (frames > 1 && last > first)
+    {
+        printf(", %.2f frames per second",
+               (frames - 1) * 1000.0 / (last - first));
+    }
+    printf("\n");
+
+    return ok;
+}
@@ -0,0 +1,31 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Lossless gameplay capture of the native 8-bit screen buffer.
+//
+
+
+#ifndef __I_CAPTURE__
+#define __I_CAPTURE__
+
+#include "doomtype.h"
+
+extern boolean capture_active;
+
+void I_StartCapture(const char *filename);
+void I_StopCapture(void);
+void I_CaptureFrame(const pixel_t *pixels, const byte *palette);
+boolean I_CaptureExport(const char *filename, const char *outdir);
+
+#endif
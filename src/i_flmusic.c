@@ -194,6 +194,11 @@ static void FL_Mix_Callback(void *udata, Uint8 *stream, int len)
     }
 }
 
+static void I_FL_Render(int16_t *buffer, int frames)
+{
+    FL_Mix_Callback(NULL, (Uint8 *) buffer, frames * 4);
+}
+
 static void I_FL_SetMusicVolume(int volume)
 {
     if (synth == NULL)
@@ -449,7 +454,9 @@ const music_module_t music_fl_module =
     I_FL_PlaySong,
     I_FL_StopSong,
     I_FL_MusicIsPlaying,
-    NULL // Poll
+    NULL, // Poll
+    I_FL_Render,
+    NULL, // Prefetch
 };
 
 #endif
@@ -102,8 +102,22 @@ typedef struct
 {
     const char *hash_prefix;
     const char *filename;
+    unsigned int order;     // [JN] Position in config load order.
+    boolean exists;         // [JN] Checked once, when configs are loaded.
 } subst_music_t;
 
+// [JN] Result of looking up a music lump, so that each lump is only
+// hashed once. The lump is identified by where its data lives, which
+// changes if its WAD is reloaded.
+typedef struct
+{
+    const wad_file_t *wad_file;
+    int position;
+    int size;
+    sha1_digest_t digest;
+    const char *filename;
+} lump_digest_t;
+
 #if !USE_SDL_MIXER_LOOPING
 // Structure containing parsed metadata read from a digital music track:
 typedef struct
@@ -114,9 +128,17 @@ typedef struct
 } file_metadata_t;
 #endif // !USE_SDL_MIXER_LOOPING
 
+// [JN] Sorted by hash prefix, then by load order, once configs are loaded.
 static subst_music_t *subst_music = NULL;
 static unsigned int subst_music_len = 0;
 
+// [JN] Bit n is set if some hash prefix is n hex digits long.
+static uint64_t subst_prefix_lengths = 0;
+
+// [JN] Lookup results, indexed by lump number.
+static lump_digest_t *lump_digests = NULL;
+static unsigned int lump_digests_len = 0;
+
 static boolean music_initialized = false;
 
 // If this is true, this module initialized SDL sound and has the 
@@ -658,6 +680,100 @@ static void ReadLoopPoints(const char *filename, file_metadata_t *metadata)
 }
 #endif // !USE_SDL_MIXER_LOOPING
 
+// [JN] Find the lump whose cached data is at the given address, or -1.
+
+static lumpindex_t FindLumpForData(const void *data, size_t data_len)
+{
+    unsigned int i;
+
+    for (i = 0; i < numlumps; ++i)
+    {
+        const lumpinfo_t *lump = lumpinfo[i];
+
+        if ((size_t) lump->size != data_len)
+        {
+            continue;
+        }
+
+        if (lump->cache == data
+         || (lump->wad_file->mapped != NULL
+          && lump->wad_file->mapped + lump->position == data))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// [JN] Look up a full hash in the sorted substitution table. As before,
+// the table can (intentionally) contain multiple filename mappings for
+// the same hash, allowing different files to be tried with fallbacks.
+// The earliest loaded entry whose file exists is preferred; failing
+// that, the last loaded match is returned so that an error message can
+// be printed saying it doesn't exist.
+
+static const char *LookupSubstitute(const char *hash_str)
+{
+    const subst_music_t *found_exists = NULL;
+    const subst_music_t *found_any = NULL;
+    char prefix[sizeof(sha1_digest_t) * 2 + 1];
+    unsigned int len;
+
+    for (len = 1; len <= sizeof(sha1_digest_t) * 2; ++len)
+    {
+        unsigned int lo, hi;
+
+        if ((subst_prefix_lengths & ((uint64_t) 1 << len)) == 0)
+        {
+            continue;
+        }
+
+        memcpy(prefix, hash_str, len);
+        prefix[len] = '\0';
+
+        // Lower bound of this prefix.
+        lo = 0;
+        hi = subst_music_len;
+        while (lo < hi)
+        {
+            const unsigned int mid = lo + (hi - lo) / 2;
+
+            if (strcmp(subst_music[mid].hash_prefix, prefix) < 0)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        for (; lo < subst_music_len
+             && !strcmp(subst_music[lo].hash_prefix, prefix); ++lo)
+        {
+            const subst_music_t *s = &subst_music[lo];
+
+            if (s->exists
+             && (found_exists == NULL || s->order < found_exists->order))
+            {
+                found_exists = s;
+            }
+            if (found_any == NULL || s->order > found_any->order)
+            {
+                found_any = s;
+            }
+        }
+    }
+
+    if (found_exists != NULL)
+    {
+        return found_exists->filename;
+    }
+
+    return found_any != NULL ? found_any->filename : NULL;
+}
+
 // Given a MUS lump, look up a substitute MUS file to play instead
 // (or NULL to just use normal MIDI playback).
 
@@ -665,8 +781,9 @@ static const char *GetSubstituteMusicFile(void *data, size_t data_len)
 {
     sha1_context_t context;
     sha1_digest_t hash;
-    const char *filename;
     char hash_str[sizeof(sha1_digest_t) * 2 + 1];
+    lump_digest_t *cached = NULL;
+    lumpindex_t lumpnum;
     unsigned int i;
 
     // Don't bother doing a hash if we're never going to find anything.
@@ -675,6 +792,32 @@ static const char *GetSubstituteMusicFile(void *data, size_t data_len)
         return NULL;
     }
 
+    // [JN] Reuse the result from the last time this lump was played.
+    lumpnum = FindLumpForData(data, data_len);
+
+    if (lumpnum >= 0)
+    {
+        const lumpinfo_t *lump = lumpinfo[lumpnum];
+
+        if ((unsigned int) lumpnum >= lump_digests_len)
+        {
+            lump_digests = I_Realloc(lump_digests,
+                                     numlumps * sizeof(*lump_digests));
+            memset(lump_digests + lump_digests_len, 0,
+                   (numlumps - lump_digests_len) * sizeof(*lump_digests));
+            lump_digests_len = numlumps;
+        }
+
+        cached = &lump_digests[lumpnum];
+
+        if (cached->wad_file == lump->wad_file
+         && cached->position == lump->position
+         && cached->size == lump->size)
+        {
+            return cached->filename;
+        }
+    }
+
     SHA1_Init(&context);
     SHA1_Update(&context, data, data_len);
     SHA1_Final(hash, &context);
@@ -686,31 +829,18 @@ static const char *GetSubstituteMusicFile(void *data, size_t data_len)
                    "%02x", hash[i]);
     }
 
-    // Look for a hash that matches.
-    // The substitute mapping list can (intentionally) contain multiple
-    // filename mappings for the same hash. This allows us to try
-    // different files and fall back if our first choice isn't found.
-
-    filename = NULL;
-
-    for (i = 0; i < subst_music_len; ++i)
+    if (cached == NULL)
     {
-        if (M_StringStartsWith(hash_str, subst_music[i].hash_prefix))
-        {
-            filename = subst_music[i].filename;
-
-            // If the file exists, then use this file in preference to
-            // any fallbacks. But we always return a filename if it's
-            // in the list, even if it's just so we can print an error
-            // message to the user saying it doesn't exist.
-            if (M_FileExists(filename))
-            {
-                break;
-            }
-        }
+        return LookupSubstitute(hash_str);
     }
 
-    return filename;
+    cached->wad_file = lumpinfo[lumpnum]->wad_file;
+    cached->position = lumpinfo[lumpnum]->position;
+    cached->size = lumpinfo[lumpnum]->size;
+    memcpy(cached->digest, hash, sizeof(sha1_digest_t));
+    cached->filename = LookupSubstitute(hash_str);
+
+    return cached->filename;
 }
 
 static char *GetFullPath(const char *musicdir, const char *path)
@@ -795,6 +925,27 @@ static void AddSubstituteMusic(const char *musicdir, const char *hash_prefix,
     s = &subst_music[subst_music_len - 1];
     s->hash_prefix = hash_prefix;
     s->filename = path;
+    s->order = subst_music_len - 1;
+    s->exists = M_FileExists(path);
+
+    subst_prefix_lengths |= (uint64_t) 1 << strlen(hash_prefix);
+}
+
+// [JN] Sort the loaded substitutions by hash prefix, so that lookups
+// are a binary search per prefix length rather than a linear scan.
+
+static int CompareSubstituteMusic(const void *a, const void *b)
+{
+    const subst_music_t *sa = a;
+    const subst_music_t *sb = b;
+    const int result = strcmp(sa->hash_prefix, sb->hash_prefix);
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return (sa->order > sb->order) - (sa->order < sb->order);
 }
 
 static const char *ReadHashPrefix(char *line)
@@ -1016,6 +1167,12 @@ static void LoadSubstituteConfigs(void)
                subst_music_len - old_music_len);
     }
 
+    if (subst_music_len > 0)
+    {
+        qsort(subst_music, subst_music_len, sizeof(subst_music_t),
+              CompareSubstituteMusic);
+    }
+
     free(musicdir);
 }
 
@@ -1101,10 +1258,195 @@ static void DumpSubstituteConfig(const char *filename)
     I_Quit();
 }
 
+// [JN] Substitute track read into memory ahead of time, so that starting
+// it doesn't block on disk. Filled in by a background thread.
+
+typedef struct
+{
+    char *filename;
+    byte *data;
+    size_t len;
+#if !USE_SDL_MIXER_LOOPING
+    file_metadata_t metadata;
+#endif
+    SDL_Thread *thread;
+} prefetch_t;
+
+static prefetch_t prefetch;
+
+// [JN] Memory buffers that registered songs are streamed from; each must
+// stay alive until its song is freed.
+
+#define MAX_MUSIC_BUFFERS 4
+
+static struct
+{
+    Mix_Music *music;
+    byte *data;
+} music_buffers[MAX_MUSIC_BUFFERS];
+
+static int PrefetchThread(void *unused)
+{
+    FILE *fs;
+    long len;
+
+    fs = M_fopen(prefetch.filename, "rb");
+
+    if (fs == NULL)
+    {
+        return 0;
+    }
+
+    if (fseek(fs, 0, SEEK_END) == 0 && (len = ftell(fs)) > 0
+     && fseek(fs, 0, SEEK_SET) == 0)
+    {
+        prefetch.data = malloc(len);
+
+        if (prefetch.data != NULL
+         && fread(prefetch.data, 1, len, fs) != (size_t) len)
+        {
+            free(prefetch.data);
+            prefetch.data = NULL;
+        }
+
+        prefetch.len = len;
+    }
+
+    fclose(fs);
+
+#if !USE_SDL_MIXER_LOOPING
+    if (prefetch.data != NULL)
+    {
+        ReadLoopPoints(prefetch.filename, &prefetch.metadata);
+    }
+#endif
+
+    return 0;
+}
+
+static void WaitPrefetch(void)
+{
+    if (prefetch.thread != NULL)
+    {
+        SDL_WaitThread(prefetch.thread, NULL);
+        prefetch.thread = NULL;
+    }
+}
+
+static void FreePrefetch(void)
+{
+    WaitPrefetch();
+    free(prefetch.filename);
+    free(prefetch.data);
+    memset(&prefetch, 0, sizeof(prefetch));
+}
+
+// [JN] Start reading the substitute for a song that is about to be
+// played, such as the next level's music during the intermission.
+
+static void I_MP_PrefetchSong(void *data, int len)
+{
+    const char *filename;
+
+    if (!music_initialized)
+    {
+        return;
+    }
+
+    filename = GetSubstituteMusicFile(data, len);
+
+    if (filename == NULL
+     || (prefetch.filename != NULL && !strcmp(prefetch.filename, filename)))
+    {
+        return;
+    }
+
+    FreePrefetch();
+
+    prefetch.filename = M_StringDuplicate(filename);
+    prefetch.thread = SDL_CreateThread(PrefetchThread, "music prefetch", NULL);
+
+    if (prefetch.thread == NULL)
+    {
+        FreePrefetch();
+    }
+}
+
+// [JN] Load a song from the prefetched buffer, if it holds the given file.
+// Returns NULL if it doesn't, so that the file is loaded normally.
+
+static Mix_Music *LoadPrefetchedSong(const char *filename)
+{
+    Mix_MusicType type = MUS_NONE;
+    Mix_Music *music;
+    SDL_RWops *rw;
+    int i;
+
+    if (prefetch.filename == NULL || strcmp(prefetch.filename, filename))
+    {
+        return NULL;
+    }
+
+    // Still loading: the rest of the read is no worse than loading from
+    // scratch.
+    WaitPrefetch();
+
+    for (i = 0; i < MAX_MUSIC_BUFFERS; ++i)
+    {
+        if (music_buffers[i].data == NULL)
+        {
+            break;
+        }
+    }
+
+    if (prefetch.data == NULL || i == MAX_MUSIC_BUFFERS)
+    {
+        FreePrefetch();
+        return NULL;
+    }
+
+    if (M_StringEndsWith(filename, ".flac"))
+    {
+        type = MUS_FLAC;
+    }
+    else if (M_StringEndsWith(filename, ".ogg"))
+    {
+        type = MUS_OGG;
+    }
+    else if (M_StringEndsWith(filename, ".mp3"))
+    {
+        type = MUS_MP3;
+    }
+
+    // The track is decoded as it plays, streaming from the buffer.
+    rw = SDL_RWFromConstMem(prefetch.data, prefetch.len);
+    music = Mix_LoadMUSType_RW(rw, type, 1);
+
+    if (music == NULL)
+    {
+        FreePrefetch();
+        return NULL;
+    }
+
+#if !USE_SDL_MIXER_LOOPING
+    file_metadata = prefetch.metadata;
+#endif
+
+    // The buffer now belongs to the song.
+    music_buffers[i].music = music;
+    music_buffers[i].data = prefetch.data;
+    prefetch.data = NULL;
+    FreePrefetch();
+
+    return music;
+}
+
 // Shutdown music
 
 static void I_MP_ShutdownMusic(void)
 {
+    FreePrefetch();
+
     if (music_initialized)
     {
         Mix_HaltMusic();
@@ -1300,6 +1642,17 @@ static void I_MP_UnRegisterSong(void *handle)
     }
 
     Mix_FreeMusic(music);
+
+    // [JN] Free the buffer it was streaming from, if any.
+    for (int i = 0; i < MAX_MUSIC_BUFFERS; ++i)
+    {
+        if (music_buffers[i].music == music)
+        {
+            free(music_buffers[i].data);
+            music_buffers[i].music = NULL;
+            music_buffers[i].data = NULL;
+        }
+    }
 }
 
 static void *I_MP_RegisterSong(void *data, int len)
@@ -1319,6 +1672,13 @@ static void *I_MP_RegisterSong(void *data, int len)
         return NULL;
     }
 
+    // [JN] Use the prefetched copy if there is one, else read the file.
+    music = LoadPrefetchedSong(filename);
+    if (music != NULL)
+    {
+        return music;
+    }
+
     music = Mix_LoadMUS(filename);
     if (music == NULL)
     {
@@ -1425,6 +1785,8 @@ const music_module_t music_pack_module =
     I_MP_StopSong,
     I_MP_MusicIsPlaying,
     I_MP_PollMusic,
+    NULL,  // Render
+    I_MP_PrefetchSong,
 };
 
 
@@ -1503,6 +1865,8 @@ const music_module_t music_pack_module =
     I_NULL_StopSong,
     I_NULL_MusicIsPlaying,
     I_NULL_PollMusic,
+    NULL,  // Render
+    NULL,  // Prefetch
 };
 
 
@@ -0,0 +1,329 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//  Offline music renderer. Every music lump is played once, without
+//  looping, through each music module that can render offline, and
+//  written to a WAV file. Synthesis is timed to report how much faster
+//  than real time each backend runs.
+//  The OPL emulator renders twice, through its SIMD and its scalar
+//  envelope pass; the two must produce identical output.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_sound.h"
+#include "i_swap.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_misc.h"
+#include "opl.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+
+// Output is synthesised in blocks of this many frames.
+#define RENDER_BLOCK  1024
+
+// Songs are cut off after this long, in case one never ends.
+#define RENDER_MAXTIME  (10 * 60)
+
+// Rendered after the song ends, so released notes can fade out.
+#define RENDER_TAILTIME  2
+
+typedef struct
+{
+    const char *name;
+    const music_module_t *module;
+    int opl_simd;       // OPL envelope pass: 1 SIMD, 0 scalar, -1 not OPL
+    int reference;      // backend whose output must match, or -1
+    uint32_t *hashes;   // output hash of each lump, 0 if not rendered
+    int mismatches;     // songs whose output differs from the reference
+    double songtime;    // seconds of music rendered
+    double rendertime;  // seconds spent rendering it
+} renderbackend_t;
+
+// FNV-1a, to compare output without keeping it around.
+
+static uint32_t HashBlock(uint32_t hash, const byte *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+//
+// I_WriteWAVHeader
+//  Writes the header of a 16-bit stereo WAV file at the start of the
+//  file, for the given length of sample data in bytes.
+//
+
+void I_WriteWAVHeader(FILE *wav, uint32_t length, int samplerate)
+{
+    unsigned int i;
+    unsigned short s;
+
+    fseek(wav, 0, SEEK_SET);
+
+    fwrite("RIFF", 1, 4, wav);
+    i = LONG(36 + length);
+    fwrite(&i, 4, 1, wav);
+    fwrite("WAVE", 1, 4, wav);
+
+    fwrite("fmt ", 1, 4, wav);
+    i = LONG(16);
+    fwrite(&i, 4, 1, wav);           // Length
+    s = SHORT(1);
+    fwrite(&s, 2, 1, wav);           // Format (PCM)
+    s = SHORT(2);
+    fwrite(&s, 2, 1, wav);           // Channels (2=stereo)
+    i = LONG(samplerate);
+    fwrite(&i, 4, 1, wav);           // Sample rate
+    i = LONG(samplerate * 2 * 2);
+    fwrite(&i, 4, 1, wav);           // Byte rate (samplerate * stereo * 16 bit)
+    s = SHORT(2 * 2);
+    fwrite(&s, 2, 1, wav);           // Block align (stereo * 16 bit)
+    s = SHORT(16);
+    fwrite(&s, 2, 1, wav);           // Bits per sample (16 bit)
+
+    fwrite("data", 1, 4, wav);
+    i = LONG(length);
+    fwrite(&i, 4, 1, wav);           // Data length
+}
+
+//
+// RenderSong
+//  Plays one song through the module into a WAV file. Returns a hash of
+//  the output, or 0 if the song failed to load.
+//
+
+static uint32_t RenderSong(renderbackend_t *backend, const char *lumpname,
+                       void *data, int len, const char *outdir)
+{
+    const music_module_t *const module = backend->module;
+    static int16_t buffer[RENDER_BLOCK * 2];
+    char filename[16];
+    char *path;
+    FILE *wav;
+    void *handle;
+    uint64_t start, elapsed = 0;
+    int frames = 0, tail = 0;
+    double songtime, rendertime;
+    uint32_t hash = 2166136261u;
+    int i;
+
+    handle = module->RegisterSong(data, len);
+
+    if (handle == NULL)
+    {
+        printf("  %-8s %-10s failed to load\n", lumpname, backend->name);
+        return 0;
+    }
+
+    M_snprintf(filename, sizeof(filename), "%s.wav", lumpname);
+    M_ForceLowercase(filename);
+    path = M_StringJoin(outdir, DIR_SEPARATOR_S, backend->name, "-",
+                        filename, NULL);
+    wav = M_fopen(path, "wb");
+
+    if (wav == NULL)
+    {
+        i_error_safe = true;
+        I_Error("I_RenderMusic: Unable to open %s", path);
+    }
+
+    I_WriteWAVHeader(wav, 0, snd_samplerate);
+
+    module->PlaySong(handle, false);
+
+    while (frames < RENDER_MAXTIME * snd_samplerate
+        && tail < RENDER_TAILTIME * snd_samplerate)
+    {
+        start = I_GetPerfCounter();
+        module->Render(buffer, RENDER_BLOCK);
+        elapsed += I_GetPerfCounter() - start;
+
+        if (!module->MusicIsPlaying())
+        {
+            tail += RENDER_BLOCK;
+        }
+
+        for (i = 0; i < RENDER_BLOCK * 2; i++)
+        {
+            buffer[i] = SHORT(buffer[i]);
+        }
+
+        hash = HashBlock(hash, (const byte *) buffer, sizeof(buffer));
+        fwrite(buffer, 4, RENDER_BLOCK, wav);
+        frames += RENDER_BLOCK;
+    }
+
+    module->StopSong();
+    module->UnRegisterSong(handle);
+
+    I_WriteWAVHeader(wav, frames * 4, snd_samplerate);
+    fclose(wav);
+    free(path);
+
+    songtime = (double) frames / snd_samplerate;
+    rendertime = (double) elapsed / I_GetPerfFrequency();
+    backend->songtime += songtime;
+    backend->rendertime += rendertime;
+
+    printf("  %-8s %-10s %7.1f s in %6.3f s = %7.1fx real time\n",
+           lumpname, backend->name, songtime, rendertime,
+           songtime / (rendertime > 0 ? rendertime : 1e-9));
+
+    return hash;
+}
+
+//
+// I_RenderMusic
+//  Renders every music lump to <outdir>/<backend>-<lump>.wav, and exits
+//  with an error if a backend's output differs from its reference.
+//
+
+void I_RenderMusic(const char *outdir)
+{
+    renderbackend_t backends[] = {
+        { "opl", &music_opl_module, 1, -1 },
+        { "opl-scalar", &music_opl_module, 0, 0 },
+#ifdef HAVE_FLUIDSYNTH
+        { "fluidsynth", &music_fl_module, -1, -1 },
+#endif
+    };
+    char lumpname[9];
+    unsigned int i, b;
+    int mismatches = 0;
+
+    M_MakeDirectory(outdir);
+
+    // Register writes must apply on this thread, as it renders.
+    OPL_SetOfflineRender(true);
+
+    printf("I_RenderMusic: Rendering music at %d Hz to %s\n",
+           snd_samplerate, outdir);
+
+    for (b = 0; b < arrlen(backends); b++)
+    {
+        renderbackend_t *const backend = &backends[b];
+
+        backend->hashes = calloc(numlumps, sizeof(*backend->hashes));
+
+        if (backend->opl_simd >= 0
+         && OPL_SetSIMD(backend->opl_simd) != backend->opl_simd)
+        {
+            printf("I_RenderMusic: %s: no SIMD OPL path in this build, "
+                   "using the scalar one.\n", backend->name);
+        }
+
+        if (!backend->module->Init())
+        {
+            printf("I_RenderMusic: %s backend unavailable.\n",
+                   backend->name);
+            continue;
+        }
+
+        backend->module->SetMusicVolume(127);
+
+        for (i = 0; i < numlumps; i++)
+        {
+            void *data;
+            int len;
+
+            M_StringCopy(lumpname, lumpinfo[i]->name, sizeof(lumpname));
+
+            // Only the lump in effect, not ones a PWAD replaces.
+            if (W_CheckNumForName(lumpname) != (lumpindex_t) i)
+            {
+                continue;
+            }
+
+            data = W_CacheLumpNum(i, PU_STATIC);
+            len = W_LumpLength(i);
+
+            if (IsMus(data, len) || IsMid(data, len))
+            {
+                const uint32_t *const expected = backend->reference >= 0 ?
+                    backends[backend->reference].hashes : NULL;
+
+                backend->hashes[i] = RenderSong(backend, lumpname,
+                                                data, len, outdir);
+
+                if (expected != NULL && expected[i] != 0
+                 && backend->hashes[i] != 0
+                 && backend->hashes[i] != expected[i])
+                {
+                    printf("  %-8s %-10s output differs from %s\n",
+                           lumpname, backend->name,
+                           backends[backend->reference].name);
+                    backend->mismatches++;
+                }
+            }
+
+            W_ReleaseLumpNum(i);
+        }
+
+        backend->module->Shutdown();
+
+        if (backend->rendertime > 0)
+        {
+            printf("I_RenderMusic: %s: %.1f s of music in %.3f s, "
+                   "%.1fx real time, %.0f samples/s\n", backend->name,
+                   backend->songtime, backend->rendertime,
+                   backend->songtime / backend->rendertime,
+                   backend->songtime * snd_samplerate / backend->rendertime);
+        }
+
+        if (backend->reference >= 0)
+        {
+            const renderbackend_t *const ref = &backends[backend->reference];
+
+            printf("I_RenderMusic: %s: %d songs differ from %s",
+                   backend->name, backend->mismatches, ref->name);
+
+            if (backend->rendertime > 0 && ref->rendertime > 0)
+            {
+                printf(", %s runs at %.2fx its speed",
+                       ref->name, (ref->songtime / ref->rendertime)
+                                / (backend->songtime / backend->rendertime));
+            }
+
+            printf("\n");
+            mismatches += backend->mismatches;
+        }
+    }
+
+    for (b = 0; b < arrlen(backends); b++)
+    {
+        free(backends[b].hashes);
+    }
+
+    OPL_SetSIMD(true);
+    OPL_SetOfflineRender(false);
+
+    if (mismatches > 0)
+    {
+        i_error_safe = true;
+        I_Error("I_RenderMusic: %d songs rendered differently by the "
+                "SIMD and scalar paths.", mismatches);
+    }
+}
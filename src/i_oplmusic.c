@@ -1690,7 +1690,16 @@ static boolean I_OPL_MusicIsPlaying(void)
         return false;
     }
 
-    return num_tracks > 0;
+    // A song that isn't looped is over once all of its tracks end.
+
+    return num_tracks > 0 && (song_looping || running_tracks > 0);
+}
+
+// Offline rendering, with OPL_SetOfflineRender set before init.
+
+static void I_OPL_Render(int16_t *buffer, int frames)
+{
+    OPL_RenderOffline(buffer, frames);
 }
 
 // Shutdown music
@@ -1794,6 +1803,8 @@ const music_module_t music_opl_module =
     I_OPL_StopSong,
     I_OPL_MusicIsPlaying,
     NULL,  // Poll
+    I_OPL_Render,
+    NULL,  // Prefetch
 };
 
 void I_SetOPLDriverVer(opl_driver_ver_t ver)
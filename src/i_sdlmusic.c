@@ -496,6 +496,8 @@ const music_module_t music_sdl_module =
     I_SDL_StopSong,
     I_SDL_MusicIsPlaying,
     NULL,  // Poll
+    NULL,  // Render
+    NULL,  // Prefetch
 };
 
 
@@ -25,6 +25,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "SDL.h"
 #include "SDL_mixer.h"
 
@@ -32,12 +42,19 @@
 #include <samplerate.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #include "deh_str.h"
 #include "i_sound.h"
 #include "i_system.h"
 #include "i_swap.h"
 #include "m_argv.h"
+#include "m_config.h"
+#include "m_fixed.h"
 #include "m_misc.h"
+#include "sha1.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -57,6 +74,23 @@ int use_libsamplerate = 1;
 
 float libsamplerate_scale = 0.65f;
 
+// [JN] Keep resampled sound effects in $configdir/sfxcache, so they
+// don't need converting again on the next startup.
+
+int snd_sfxcache = 1;
+
+// [JN] Mix sound effects with our own mixer instead of SDL_mixer's
+// channels: 1 starts sounds in the next buffer, for the lowest latency,
+// 2 delays them by one callback period, so they start exactly to the
+// sample.
+
+int snd_crlmixer = 0;
+
+// [JN] Audio buffer length limit with snd_crlmixer, in place of
+// snd_maxslicetime_ms, as our mixer copes with shorter buffers.
+
+int snd_crlmixer_slicetime_ms = 12;
+
 
 #ifndef DISABLE_SDL2MIXER
 
@@ -74,6 +108,7 @@ struct allocated_sound_s
     int use_count;
     int pitch;
     allocated_sound_t *prev, *next;
+    allocated_sound_t *hashnext;  // pitch variants only
 };
 
 static boolean sound_initialized = false;
@@ -84,10 +119,109 @@ static int mixer_freq;
 static Uint16 mixer_format;
 static int mixer_channels;
 static boolean use_sfx_prefix;
-static boolean (*ExpandSoundData)(sfxinfo_t *sfxinfo,
-                                  byte *data,
-                                  int samplerate,
-                                  int length) = NULL;
+static allocated_sound_t *(*ExpandSoundData)(sfxinfo_t *sfxinfo,
+                                             byte *data,
+                                             int samplerate,
+                                             int length) = NULL;
+
+// [JN] Channels of our own mixer, used instead of SDL_mixer's channels if
+// snd_crlmixer is set.  It runs as SDL_mixer's post-mix callback, so
+// sound effects are added on top of the music SDL_mixer has mixed.
+// The game thread and the callback share them under mix_lock.
+
+typedef struct
+{
+    allocated_sound_t *snd;  // NULL if idle
+    unsigned int pos;        // next frame to mix
+    unsigned int delay;      // frames of silence before it starts
+    int left, right;         // gain, 256 is unity
+    uint64_t start_time;     // when started, 0 once the mixer has seen it
+    boolean done;
+} mix_channel_t;
+
+// The mixer works through its callback's buffer in blocks this long.
+#define MIX_BLOCK 512
+
+static boolean use_crl_mixer = false;
+
+// snd_crlmixer 2: sounds start where in the callback period they were
+// started, measured from the previous callback.
+static boolean mix_exact_start = false;
+static uint64_t mix_last_callback;
+
+// [JN] True if there is no audio device, and the mixer is driven by the
+// -soundsink output instead.
+static boolean sink_mode = false;
+static mix_channel_t mix_channels[NUM_CHANNELS];
+static SDL_SpinLock mix_lock;
+static int32_t mix_accum[MIX_BLOCK * 2];
+
+// Time spent in the mixer, and how much audio it produced.
+static uint64_t mix_time, mix_frames;
+static unsigned int mix_callbacks;
+
+// Directory of the on-disk cache of resampled sounds, NULL if disabled.
+
+static char *sfxcache_dir = NULL;
+
+// Bumped when the conversion code changes what it outputs, so stale
+// cache entries are no longer found.
+
+#define SFXCACHE_VERSION 1
+
+// Precaching converts sounds on at most this many threads.
+
+#define MAX_PRECACHE_THREADS 16
+
+// [JN] Pitch-shifted variants are kept apart from the base sounds, in a
+// hash table on (sfx, pitch) and an LRU list held within
+// snd_pitchcachesize bytes.
+
+#define PITCHCACHE_HASHSIZE 1024
+
+static allocated_sound_t *pitch_hash[PITCHCACHE_HASHSIZE];
+static allocated_sound_t *pitched_sounds_head = NULL;
+static allocated_sound_t *pitched_sounds_tail = NULL;
+static int pitched_sounds_size = 0;
+static unsigned int pitch_hits, pitch_misses;
+
+// The first time a sound is missing a pitch, the pitches of the random
+// variation around NORM_PITCH that are not cached yet are made for it
+// on a background thread.  Until then it plays unshifted, so starting a
+// sound never resamples.  The range is Doom's, 16 - (M_Random() & 31);
+// Heretic's +/-7 falls within it.
+
+#define PITCHSET_MIN (NORM_PITCH - 15)
+#define PITCHSET_MAX (NORM_PITCH + 16)
+
+// The set, plus the missing pitch in case it is outside of it.
+#define PITCHSET_SIZE (PITCHSET_MAX - PITCHSET_MIN + 2)
+
+#define NUM_PITCH_REQUESTS 64
+
+typedef enum
+{
+    PITCH_REQUEST_FREE,
+    PITCH_REQUEST_PENDING,
+    PITCH_REQUEST_WORKING,
+    PITCH_REQUEST_DONE,
+} pitch_request_state_t;
+
+typedef struct
+{
+    pitch_request_state_t state;
+    allocated_sound_t *base;  // locked until the request is collected
+    int pitches[PITCHSET_SIZE];  // missing from the cache
+    int num_pitches;
+    allocated_sound_t *variants[PITCHSET_SIZE];
+    int num_variants;
+} pitch_request_t;
+
+static pitch_request_t pitch_requests[NUM_PITCH_REQUESTS];
+static SDL_mutex *pitch_mutex = NULL;
+static SDL_sem *pitch_sem = NULL;
+static SDL_Thread *pitch_thread = NULL;
+static SDL_atomic_t pitch_quit;
 
 // Doubly-linked list of allocated sounds.
 // When a sound is played, it is moved to the head, so that the oldest
@@ -204,32 +338,21 @@ static void ReserveCacheSpace(size_t len)
     }
 }
 
-// Allocate a block for a new sound effect.
+// Allocate the sound structure and data, not yet linked into the list
+// of allocated sounds.  The data will immediately follow the structure,
+// which acts as a header.  Touches no shared state, so it can be used
+// by the precache threads.
 
-static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
+static allocated_sound_t *NewSound(sfxinfo_t *sfxinfo, size_t len)
 {
     allocated_sound_t *snd;
 
-    // Keep allocated sounds within the cache size.
-
-    ReserveCacheSpace(len);
-
-    // Allocate the sound structure and data.  The data will immediately
-    // follow the structure, which acts as a header.
+    snd = malloc(sizeof(allocated_sound_t) + len);
 
-    do
+    if (snd == NULL)
     {
-        snd = malloc(sizeof(allocated_sound_t) + len);
-
-        // Out of memory?  Try to free an old sound, then loop round
-        // and try again.
-
-        if (snd == NULL && !FindAndFreeSound())
-        {
-            return NULL;
-        }
-
-    } while (snd == NULL);
+        return NULL;
+    }
 
     // Skip past the chunk structure for the audio buffer
 
@@ -242,13 +365,139 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
     snd->sfxinfo = sfxinfo;
     snd->use_count = 0;
 
+    return snd;
+}
+
+// Add a sound made by NewSound to the list of allocated sounds.
+
+static void LinkSound(allocated_sound_t *snd)
+{
+    // Keep allocated sounds within the cache size.
+
+    ReserveCacheSpace(snd->chunk.alen);
+
     // Keep track of how much memory all these cached sounds are using...
 
-    allocated_sounds_size += len;
+    allocated_sounds_size += snd->chunk.alen;
 
     AllocatedSoundLink(snd);
+}
 
-    return snd;
+static int PitchHash(const sfxinfo_t *sfxinfo, int pitch)
+{
+    return (((uintptr_t) sfxinfo >> 3) * 31 + pitch)
+         & (PITCHCACHE_HASHSIZE - 1);
+}
+
+static allocated_sound_t *PitchCacheFind(const sfxinfo_t *sfxinfo, int pitch)
+{
+    allocated_sound_t *snd;
+
+    for (snd = pitch_hash[PitchHash(sfxinfo, pitch)] ; snd != NULL ;
+         snd = snd->hashnext)
+    {
+        if (snd->sfxinfo == sfxinfo && snd->pitch == pitch)
+        {
+            return snd;
+        }
+    }
+
+    return NULL;
+}
+
+static void PitchCacheLink(allocated_sound_t *snd)
+{
+    snd->prev = NULL;
+    snd->next = pitched_sounds_head;
+    pitched_sounds_head = snd;
+
+    if (pitched_sounds_tail == NULL)
+    {
+        pitched_sounds_tail = snd;
+    }
+    else
+    {
+        snd->next->prev = snd;
+    }
+}
+
+static void PitchCacheUnlink(allocated_sound_t *snd)
+{
+    if (snd->prev == NULL)
+    {
+        pitched_sounds_head = snd->next;
+    }
+    else
+    {
+        snd->prev->next = snd->next;
+    }
+
+    if (snd->next == NULL)
+    {
+        pitched_sounds_tail = snd->prev;
+    }
+    else
+    {
+        snd->next->prev = snd->prev;
+    }
+}
+
+// Add a pitch variant made by PitchShift, or free it if the cache has
+// one already.
+
+static void PitchCacheInsert(allocated_sound_t *snd)
+{
+    const int hash = PitchHash(snd->sfxinfo, snd->pitch);
+
+    if (PitchCacheFind(snd->sfxinfo, snd->pitch) != NULL)
+    {
+        free(snd);
+        return;
+    }
+
+    snd->hashnext = pitch_hash[hash];
+    pitch_hash[hash] = snd;
+
+    PitchCacheLink(snd);
+    pitched_sounds_size += snd->chunk.alen;
+}
+
+static void PitchCacheFree(allocated_sound_t *snd)
+{
+    allocated_sound_t **prev = &pitch_hash[PitchHash(snd->sfxinfo,
+                                                     snd->pitch)];
+
+    while (*prev != snd)
+    {
+        prev = &(*prev)->hashnext;
+    }
+
+    *prev = snd->hashnext;
+
+    PitchCacheUnlink(snd);
+    pitched_sounds_size -= snd->chunk.alen;
+
+    free(snd);
+}
+
+// Free the least recently used variants not being played, until the
+// cache is within its budget.
+
+static void PitchCacheTrim(void)
+{
+    allocated_sound_t *snd = pitched_sounds_tail;
+
+    while (snd != NULL && pitched_sounds_size > snd_pitchcachesize)
+    {
+        allocated_sound_t *const prev = snd->prev;
+
+        if (snd->use_count == 0)
+        {
+            PitchCacheFree(snd);
+        }
+
+        snd = prev;
+    }
 }
 
 // Lock a sound, to indicate that it may not be freed.
@@ -264,8 +513,16 @@ static void LockAllocatedSound(allocated_sound_t *snd)
     // When we use a sound, re-link it into the list at the head, so
     // that the oldest sounds fall to the end of the list for freeing.
 
-    AllocatedSoundUnlink(snd);
-    AllocatedSoundLink(snd);
+    if (snd->pitch == NORM_PITCH)
+    {
+        AllocatedSoundUnlink(snd);
+        AllocatedSoundLink(snd);
+    }
+    else
+    {
+        PitchCacheUnlink(snd);
+        PitchCacheLink(snd);
+    }
 }
 
 // Unlock a sound to indicate that it may now be freed.
@@ -302,7 +559,8 @@ static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(const sfxinfo_t *s
 }
 
 // Allocate a new sound chunk and pitch-shift an existing sound up-or-down
-// into it.
+// into it.  The new sound is not added to the pitch cache, so this can
+// run on the pitch thread.
 
 static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
 {
@@ -325,7 +583,7 @@ static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
         dstlen++;
     }
 
-    outsnd = AllocateSound(insnd->sfxinfo, dstlen);
+    outsnd = NewSound(insnd->sfxinfo, dstlen);
 
     if (!outsnd)
     {
@@ -345,30 +603,403 @@ static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
     return outsnd;
 }
 
-// When a sound stops, check if it is still playing.  If it is not,
-// we can mark the sound data as CACHE to be freed back for other
-// means.
-
-static void ReleaseSoundOnChannel(int channel)
+// [JN] Add a stereo 16-bit sound into the 32-bit accumulator, at the
+// given gains.
+
+static void MixSamples(int32_t *accum, const Sint16 *samples, int frames,
+                       int left, int right)
+{
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i gain = _mm_set_epi16(right, left, right, left,
+                                       right, left, right, left);
+
+    for ( ; i + 8 <= frames * 2 ; i += 8)
+    {
+        const __m128i in = _mm_loadu_si128((const __m128i *) (samples + i));
+        const __m128i lo = _mm_mullo_epi16(in, gain);
+        const __m128i hi = _mm_mulhi_epi16(in, gain);
+        __m128i *const out = (__m128i *) (accum + i);
+
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out),
+                                            _mm_unpacklo_epi16(lo, hi)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1),
+                                                _mm_unpackhi_epi16(lo, hi)));
+    }
+#endif
+
+    for ( ; i < frames * 2 ; i += 2)
+    {
+        accum[i] += samples[i] * left;
+        accum[i + 1] += samples[i + 1] * right;
+    }
+}
+
+// [JN] Add the accumulated sound effects to the output, with clipping.
+
+static void MixOutput(Sint16 *stream, const int32_t *accum, int frames)
+{
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    for ( ; i + 8 <= frames * 2 ; i += 8)
+    {
+        const __m128i a0 = _mm_srai_epi32(
+            _mm_loadu_si128((const __m128i *) (accum + i)), 8);
+        const __m128i a1 = _mm_srai_epi32(
+            _mm_loadu_si128((const __m128i *) (accum + i + 4)), 8);
+        __m128i *const out = (__m128i *) (stream + i);
+
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out),
+                                             _mm_packs_epi32(a0, a1)));
+    }
+#endif
+
+    for ( ; i < frames * 2 ; ++i)
+    {
+        const int sfx = BETWEEN(-32768, 32767, accum[i] >> 8);
+
+        stream[i] = BETWEEN(-32768, 32767, stream[i] + sfx);
+    }
+}
+
+// [JN] Mix all playing channels into a stereo 16-bit buffer.
+// Sounds normally start at the beginning of the next buffer.  With
+// mix_exact_start, a sound is placed as far into the buffer as it was
+// started after the previous callback, so it is heard one period after
+// it was started, exact to the sample instead of jittering by up to a
+// buffer.
+
+static void MixChannels(Sint16 *stream, int frames)
+{
+    const uint64_t freq = SDL_GetPerformanceFrequency();
+    int block, n, i;
+
+    SDL_AtomicLock(&mix_lock);
+
+    for (i = 0; i < NUM_CHANNELS; ++i)
+    {
+        mix_channel_t *const ch = &mix_channels[i];
+
+        if (ch->snd != NULL && ch->start_time != 0)
+        {
+            ch->delay = 0;
+
+            if (mix_exact_start && mix_last_callback != 0
+             && ch->start_time > mix_last_callback)
+            {
+                const uint64_t offset = (ch->start_time - mix_last_callback)
+                                      * mixer_freq / freq;
+
+                ch->delay = offset < (uint64_t) frames ?
+                            (unsigned int) offset : frames - 1;
+            }
+
+            ch->start_time = 0;
+        }
+    }
+
+    for (block = 0; block < frames; block += n)
+    {
+        n = MIN(MIX_BLOCK, frames - block);
+
+        memset(mix_accum, 0, n * 2 * sizeof(*mix_accum));
+
+        for (i = 0; i < NUM_CHANNELS; ++i)
+        {
+            mix_channel_t *const ch = &mix_channels[i];
+            unsigned int length, skip, count;
+
+            if (ch->snd == NULL || ch->done)
+            {
+                continue;
+            }
+
+            length = ch->snd->chunk.alen / 4;
+            skip = MIN(ch->delay, (unsigned int) n);
+            count = MIN(n - skip, length - ch->pos);
+            ch->delay -= skip;
+
+            MixSamples(mix_accum + skip * 2,
+                       (const Sint16 *) ch->snd->chunk.abuf + ch->pos * 2,
+                       count, ch->left, ch->right);
+
+            ch->pos += count;
+
+            if (ch->pos >= length)
+            {
+                ch->done = true;
+            }
+        }
+
+        MixOutput(stream + block * 2, mix_accum, n);
+    }
+
+    SDL_AtomicUnlock(&mix_lock);
+}
+
+// [JN] Mix sound effects into a buffer of the -soundsink output.
+
+void I_SDL_MixSink(int16_t *buffer, int frames)
+{
+    if (sound_initialized && sink_mode)
+    {
+        MixChannels(buffer, frames);
+    }
+}
+
+static void MixCallback(void *udata, Uint8 *stream, int len)
+{
+    const uint64_t start = SDL_GetPerformanceCounter();
+
+    MixChannels((Sint16 *) stream, len / 4);
+    mix_last_callback = start;
+
+    mix_time += SDL_GetPerformanceCounter() - start;
+    mix_frames += len / 4;
+    ++mix_callbacks;
+}
+
+// When a sound stops, check if it is still playing.  If it is not,
+// we can mark the sound data as CACHE to be freed back for other
+// means.
+
+static void ReleaseSoundOnChannel(int channel)
+{
+    allocated_sound_t *snd = channels_playing[channel];
+
+    if (use_crl_mixer)
+    {
+        SDL_AtomicLock(&mix_lock);
+        mix_channels[channel].snd = NULL;
+        SDL_AtomicUnlock(&mix_lock);
+    }
+    else
+    {
+        Mix_HaltChannel(channel);
+    }
+
+    if (snd == NULL)
+    {
+        return;
+    }
+
+    channels_playing[channel] = NULL;
+
+    UnlockAllocatedSound(snd);
+}
+
+static void AddPitchVariant(pitch_request_t *request, int pitch)
+{
+    allocated_sound_t *const snd = PitchShift(request->base, pitch);
+
+    if (snd != NULL)
+    {
+        request->variants[request->num_variants++] = snd;
+    }
+}
+
+// Pitch thread: makes the pitch set of each requested sound.
+
+static int PitchThread(void *unused)
+{
+    for (;;)
+    {
+        pitch_request_t *request = NULL;
+        int i;
+
+        SDL_SemWait(pitch_sem);
+
+        if (SDL_AtomicGet(&pitch_quit))
+        {
+            break;
+        }
+
+        SDL_LockMutex(pitch_mutex);
+
+        for (i = 0; i < NUM_PITCH_REQUESTS; ++i)
+        {
+            if (pitch_requests[i].state == PITCH_REQUEST_PENDING)
+            {
+                request = &pitch_requests[i];
+                request->state = PITCH_REQUEST_WORKING;
+                break;
+            }
+        }
+
+        SDL_UnlockMutex(pitch_mutex);
+
+        if (request == NULL)
+        {
+            continue;
+        }
+
+        request->num_variants = 0;
+
+        for (i = 0; i < request->num_pitches; ++i)
+        {
+            AddPitchVariant(request, request->pitches[i]);
+        }
+
+        SDL_LockMutex(pitch_mutex);
+        request->state = PITCH_REQUEST_DONE;
+        SDL_UnlockMutex(pitch_mutex);
+    }
+
+    return 0;
+}
+
+// Ask the pitch thread for the pitches of a sound's set that are not
+// cached, plus the missing one, unless it is already working on the
+// sound.  Returns false if no request can be made.
+
+static boolean RequestPitchSet(allocated_sound_t *base, int pitch)
+{
+    pitch_request_t *request = NULL;
+    int i, p;
+
+    if (pitch_thread == NULL)
+    {
+        return false;
+    }
+
+    SDL_LockMutex(pitch_mutex);
+
+    for (i = 0; i < NUM_PITCH_REQUESTS; ++i)
+    {
+        if (pitch_requests[i].state == PITCH_REQUEST_FREE)
+        {
+            if (request == NULL)
+            {
+                request = &pitch_requests[i];
+            }
+        }
+        else if (pitch_requests[i].base == base)
+        {
+            SDL_UnlockMutex(pitch_mutex);
+            return true;
+        }
+    }
+
+    if (request != NULL)
+    {
+        LockAllocatedSound(base);
+        request->base = base;
+        request->num_pitches = 0;
+
+        for (p = PITCHSET_MIN; p <= PITCHSET_MAX; ++p)
+        {
+            if (p != NORM_PITCH && PitchCacheFind(base->sfxinfo, p) == NULL)
+            {
+                request->pitches[request->num_pitches++] = p;
+            }
+        }
+
+        if (pitch < PITCHSET_MIN || pitch > PITCHSET_MAX)
+        {
+            request->pitches[request->num_pitches++] = pitch;
+        }
+
+        request->state = PITCH_REQUEST_PENDING;
+    }
+
+    SDL_UnlockMutex(pitch_mutex);
+
+    if (request == NULL)
+    {
+        return false;
+    }
+
+    SDL_SemPost(pitch_sem);
+
+    return true;
+}
+
+// Add the pitch sets the pitch thread has finished to the cache.
+
+static void CollectPitchSets(void)
+{
+    boolean collected = false;
+    int i, j;
+
+    if (pitch_thread == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(pitch_mutex);
+
+    for (i = 0; i < NUM_PITCH_REQUESTS; ++i)
+    {
+        pitch_request_t *const request = &pitch_requests[i];
+
+        if (request->state != PITCH_REQUEST_DONE)
+        {
+            continue;
+        }
+
+        for (j = 0; j < request->num_variants; ++j)
+        {
+            PitchCacheInsert(request->variants[j]);
+        }
+
+        UnlockAllocatedSound(request->base);
+        request->base = NULL;
+        request->state = PITCH_REQUEST_FREE;
+        collected = true;
+    }
+
+    SDL_UnlockMutex(pitch_mutex);
+
+    if (collected)
+    {
+        PitchCacheTrim();
+    }
+}
+
+static void StartPitchThread(void)
 {
-    allocated_sound_t *snd = channels_playing[channel];
+    int i;
 
-    Mix_HaltChannel(channel);
+    for (i = 0; i < NUM_PITCH_REQUESTS; ++i)
+    {
+        pitch_requests[i].state = PITCH_REQUEST_FREE;
+        pitch_requests[i].base = NULL;
+    }
 
-    if (snd == NULL)
+    pitch_mutex = SDL_CreateMutex();
+    pitch_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&pitch_quit, 0);
+
+    pitch_thread = SDL_CreateThread(PitchThread, "SFX pitch", NULL);
+
+    if (pitch_thread == NULL)
     {
-        return;
+        fprintf(stderr, "StartPitchThread: %s\n", SDL_GetError());
     }
+}
 
-    channels_playing[channel] = NULL;
+static void StopPitchThread(void)
+{
+    if (pitch_thread != NULL)
+    {
+        SDL_AtomicSet(&pitch_quit, 1);
+        SDL_SemPost(pitch_sem);
+        SDL_WaitThread(pitch_thread, NULL);
+        pitch_thread = NULL;
+    }
 
-    UnlockAllocatedSound(snd);
+    if (pitch_sem != NULL)
+    {
+        SDL_DestroySemaphore(pitch_sem);
+        pitch_sem = NULL;
+    }
 
-    // if the sound is a pitch-shift and it's not in use, immediately
-    // free it
-    if (snd->pitch != NORM_PITCH && snd->use_count <= 0)
+    if (pitch_mutex != NULL)
     {
-        FreeAllocatedSound(snd);
+        SDL_DestroyMutex(pitch_mutex);
+        pitch_mutex = NULL;
     }
 }
 
@@ -405,16 +1036,16 @@ static int SRC_ConversionMode(void)
 //   unsigned 8 bits --> signed 16 bits
 //   mono --> stereo
 //   samplerate --> mixer_freq
-// Returns number of clipped samples.
+// Returns the new sound, not yet linked, or NULL.
 // DWF 2008-02-10 with cleanups by Simon Howard.
-int retn;  // [JN] Exernalized, purely to shutup compiler warning.
 
-static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int length)
+static allocated_sound_t *ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
+                                              byte *data,
+                                              int samplerate,
+                                              int length)
 {
     SRC_DATA src_data;
+    int retn;
     float *data_in;
     uint32_t i, abuf_index=0, clipped=0;
 //    uint32_t alen;
@@ -447,16 +1078,19 @@ static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
 
     retn = src_simple(&src_data, SRC_ConversionMode(), 1);
     assert(retn == 0);
+    (void) retn;
 
     // Allocate the new chunk.
 
 //    alen = src_data.output_frames_gen * 4;
 
-    snd = AllocateSound(sfxinfo, src_data.output_frames_gen * 4);
+    snd = NewSound(sfxinfo, src_data.output_frames_gen * 4);
 
     if (snd == NULL)
     {
-        return false;
+        free(data_in);
+        free(src_data.data_out);
+        return NULL;
     }
 
     chunk = &snd->chunk;
@@ -519,7 +1153,7 @@ static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
                         400.0 * clipped / chunk->alen);
     }
 
-    return true;
+    return snd;
 }
 
 #endif
@@ -604,12 +1238,12 @@ static void WriteWAV(const char *filename, const byte *data,
 #endif
 
 // Generic sound expansion function for any sample rate.
-// Returns number of clipped samples (always 0).
+// Returns the new sound, not yet linked, or NULL.
 
-static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int length)
+static allocated_sound_t *ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
+                                              byte *data,
+                                              int samplerate,
+                                              int length)
 {
     SDL_AudioCVT convertor;
     allocated_sound_t *snd;
@@ -626,11 +1260,11 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 
     // Allocate a chunk in which to expand the sound
 
-    snd = AllocateSound(sfxinfo, expanded_length);
+    snd = NewSound(sfxinfo, expanded_length);
 
     if (snd == NULL)
     {
-        return false;
+        return NULL;
     }
 
     chunk = &snd->chunk;
@@ -717,17 +1351,18 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 #endif /* #ifdef LOW_PASS_FILTER */
     }
 
-    return true;
+    return snd;
 }
 
-// Load and convert a sound effect
-// Returns true if successful
+// Load a sound effect lump and check it is a valid sound.  Returns
+// true and the sample data, rate and length if it is; the lump then
+// stays cached until the caller releases it.
 
-static boolean CacheSFX(sfxinfo_t *sfxinfo)
+static boolean LoadSFXLump(sfxinfo_t *sfxinfo, byte **samples,
+                           int *samplerate, unsigned int *samplecount)
 {
     int lumpnum;
     unsigned int lumplen;
-    int samplerate;
     unsigned int length;
     byte *data;
 
@@ -744,12 +1379,13 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
     {
         // Invalid sound
 
+        W_ReleaseLumpNum(lumpnum);
         return false;
     }
 
     // 16 bit sample rate field, 32 bit length field
 
-    samplerate = (data[3] << 8) | data[2];
+    *samplerate = (data[3] << 8) | data[2];
     length = (data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4];
 
     // If the header specifies that the length of the sound is greater than
@@ -763,38 +1399,213 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
 
     if (length > lumplen - 8 || length <= 48)
     {
+        W_ReleaseLumpNum(lumpnum);
         return false;
     }
 
     // The DMX sound library seems to skip the first 16 and last 16
     // bytes of the lump - reason unknown.
 
-    data += 16;
-    length -= 32;
+    *samples = data + 16 + 8;
+    *samplecount = length - 32;
+
+    return true;
+}
+
+// Name of the disk cache file for the given samples converted with the
+// current output format and resampler settings.
+
+static char *SFXCachePath(byte *samples, int samplerate,
+                          unsigned int length)
+{
+    sha1_context_t context;
+    sha1_digest_t digest;
+    char name[sizeof(digest) * 2 + 5];
+    int i;
+
+    SHA1_Init(&context);
+    SHA1_UpdateInt32(&context, SFXCACHE_VERSION);
+    SHA1_UpdateInt32(&context, mixer_freq);
+    SHA1_UpdateInt32(&context, mixer_format);
+    SHA1_UpdateInt32(&context, mixer_channels);
+    SHA1_UpdateInt32(&context, ExpandSoundData == ExpandSoundData_SDL ?
+                               0 : use_libsamplerate);
+    SHA1_UpdateInt32(&context, (unsigned int) (libsamplerate_scale * 65536));
+    SHA1_UpdateInt32(&context, samplerate);
+    SHA1_UpdateInt32(&context, length);
+    SHA1_Update(&context, samples, length);
+    SHA1_Final(digest, &context);
+
+    for (i = 0; i < sizeof(digest); i++)
+    {
+        M_snprintf(name + i * 2, 3, "%02x", digest[i]);
+    }
+
+    M_StringCopy(name + i * 2, ".pcm", 5);
+
+    return M_StringJoin(sfxcache_dir, name, NULL);
+}
+
+static allocated_sound_t *ReadSFXCache(sfxinfo_t *sfxinfo, const char *path)
+{
+    allocated_sound_t *snd;
+    byte header[8];
+    uint32_t len;
+    FILE *f;
+
+    f = M_fopen(path, "rb");
+
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    if (fread(header, 1, sizeof(header), f) != sizeof(header)
+     || memcmp(header, "SFXC", 4) != 0)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    len = header[4] | (header[5] << 8) | (header[6] << 16)
+        | ((uint32_t) header[7] << 24);
+
+    snd = NewSound(sfxinfo, len);
+
+    if (snd != NULL && fread(snd->chunk.abuf, 1, len, f) != len)
+    {
+        free(snd);
+        snd = NULL;
+    }
+
+    fclose(f);
+
+    return snd;
+}
+
+// Written under a temporary name and renamed, so a partly written file
+// is never found, even by another instance running at the same time.
+// The name has both the process and the thread id, as thread ids are
+// only unique within a process.
+
+static void WriteSFXCache(const allocated_sound_t *snd, const char *path)
+{
+    const uint32_t len = snd->chunk.alen;
+    byte header[8];
+    char suffix[32];
+    char *temp;
+    FILE *f;
+    boolean ok;
+
+#ifdef _WIN32
+    M_snprintf(suffix, sizeof(suffix), ".%lu-%lu.tmp",
+               (unsigned long) GetCurrentProcessId(),
+               (unsigned long) SDL_ThreadID());
+#else
+    M_snprintf(suffix, sizeof(suffix), ".%ld-%lu.tmp",
+               (long) getpid(), (unsigned long) SDL_ThreadID());
+#endif
+    temp = M_StringJoin(path, suffix, NULL);
+    f = M_fopen(temp, "wb");
+
+    if (f == NULL)
+    {
+        free(temp);
+        return;
+    }
+
+    memcpy(header, "SFXC", 4);
+    header[4] = len & 0xff;
+    header[5] = (len >> 8) & 0xff;
+    header[6] = (len >> 16) & 0xff;
+    header[7] = (len >> 24) & 0xff;
+
+    ok = fwrite(header, 1, sizeof(header), f) == sizeof(header)
+      && fwrite(snd->chunk.abuf, 1, len, f) == len;
+    ok = fclose(f) == 0 && ok;
+
+    if (!ok || M_rename(temp, path) != 0)
+    {
+        M_remove(temp);
+    }
+
+    free(temp);
+}
+
+// Convert the samples of a sound effect to the output format, or load
+// the result of an earlier conversion from the disk cache.  Returns the
+// new sound, not yet linked, or NULL.  Safe to call from the precache
+// threads.
+
+static allocated_sound_t *ExpandSFX(sfxinfo_t *sfxinfo, byte *samples,
+                                    int samplerate, unsigned int length)
+{
+    allocated_sound_t *snd;
+    char *path;
+
+    if (sfxcache_dir == NULL)
+    {
+        return ExpandSoundData(sfxinfo, samples, samplerate, length);
+    }
+
+    path = SFXCachePath(samples, samplerate, length);
+    snd = ReadSFXCache(sfxinfo, path);
+
+    if (snd == NULL)
+    {
+        snd = ExpandSoundData(sfxinfo, samples, samplerate, length);
+
+        if (snd != NULL)
+        {
+            WriteSFXCache(snd, path);
+        }
+    }
+
+    free(path);
+
+    return snd;
+}
+
+// Load and convert a sound effect
+// Returns true if successful
+
+static boolean CacheSFX(sfxinfo_t *sfxinfo)
+{
+    allocated_sound_t *snd;
+    byte *samples;
+    int samplerate;
+    unsigned int length;
+
+    if (!LoadSFXLump(sfxinfo, &samples, &samplerate, &length))
+    {
+        return false;
+    }
 
     // Sample rate conversion
 
-    if (!ExpandSoundData(sfxinfo, data + 8, samplerate, length))
+    snd = ExpandSFX(sfxinfo, samples, samplerate, length);
+
+    // don't need the original lump any more
+
+    W_ReleaseLumpNum(sfxinfo->lumpnum);
+
+    if (snd == NULL)
     {
         return false;
     }
 
+    LinkSound(snd);
+
 #ifdef DEBUG_DUMP_WAVS
     {
         char filename[16];
-        const allocated_sound_t * snd;
 
         M_snprintf(filename, sizeof(filename), "%s.wav",
                    DEH_String(sfxinfo->name));
-        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
-        WriteWAV(filename, snd->chunk.abuf, snd->chunk.alen,mixer_freq);
+        WriteWAV(filename, snd->chunk.abuf, snd->chunk.alen, mixer_freq);
     }
 #endif
 
-    // don't need the original lump any more
-  
-    W_ReleaseLumpNum(lumpnum);
-
     return true;
 }
 
@@ -820,10 +1631,44 @@ static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
     }
 }
 
-// Preload all the sound effects - stops nasty ingame freezes
+// Sound effects converted by the precache threads.
+
+typedef struct
+{
+    sfxinfo_t *sfxinfo;
+    byte *samples;
+    int samplerate;
+    unsigned int length;
+    allocated_sound_t *snd;
+} precache_job_t;
+
+static precache_job_t *precache_jobs;
+static int num_precache_jobs;
+static SDL_atomic_t next_precache_job;
+
+static int PrecacheThread(void *unused)
+{
+    int i;
+
+    while ((i = SDL_AtomicAdd(&next_precache_job, 1)) < num_precache_jobs)
+    {
+        precache_job_t *const job = &precache_jobs[i];
+
+        job->snd = ExpandSFX(job->sfxinfo, job->samples,
+                             job->samplerate, job->length);
+    }
+
+    return 0;
+}
+
+// Preload all the sound effects - stops nasty ingame freezes.
+// Lumps are read here, as the WAD and zone code are not thread-safe,
+// and converted on one thread per CPU core.
 
 static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
 {
+    SDL_Thread *threads[MAX_PRECACHE_THREADS];
+    int num_threads;
     char namebuf[9];
     int i;
     static boolean precached = false;  // [JN] Precache SFX only once.
@@ -835,7 +1680,53 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
 
     printf("I_SDL_PrecacheSounds: Precaching all sound effects - [");
 
+    precache_jobs = malloc(num_sounds * sizeof(*precache_jobs));
+    num_precache_jobs = 0;
+
     for (i=0; i<num_sounds; ++i)
+    {
+        precache_job_t *const job = &precache_jobs[num_precache_jobs];
+
+        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
+
+        sounds[i].lumpnum = W_CheckNumForName(namebuf);
+
+        if (sounds[i].lumpnum != -1
+         && LoadSFXLump(&sounds[i], &job->samples, &job->samplerate,
+                        &job->length))
+        {
+            job->sfxinfo = &sounds[i];
+            job->snd = NULL;
+            ++num_precache_jobs;
+        }
+    }
+
+    // This thread converts sounds as well.
+
+    SDL_AtomicSet(&next_precache_job, 0);
+    num_threads = SDL_GetCPUCount() - 1;
+
+    if (num_threads > MAX_PRECACHE_THREADS)
+    {
+        num_threads = MAX_PRECACHE_THREADS;
+    }
+
+    for (i = 0; i < num_threads; ++i)
+    {
+        threads[i] = SDL_CreateThread(PrecacheThread, "SFX precache", NULL);
+    }
+
+    PrecacheThread(NULL);
+
+    for (i = 0; i < num_threads; ++i)
+    {
+        if (threads[i] != NULL)
+        {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+
+    for (i = 0; i < num_precache_jobs; ++i)
     {
         if ((i % 6) == 0)
         {
@@ -843,16 +1734,18 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
             fflush(stdout);
         }
 
-        GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
-
-        sounds[i].lumpnum = W_CheckNumForName(namebuf);
-
-        if (sounds[i].lumpnum != -1)
+        if (precache_jobs[i].snd != NULL)
         {
-            CacheSFX(&sounds[i]);
+            LinkSound(precache_jobs[i].snd);
         }
+
+        W_ReleaseLumpNum(precache_jobs[i].sfxinfo->lumpnum);
     }
 
+    free(precache_jobs);
+    precache_jobs = NULL;
+    num_precache_jobs = 0;
+
     printf("]\n");
     
     precached = true;
@@ -891,6 +1784,17 @@ static int I_SDL_GetSfxLumpNum(sfxinfo_t *sfx)
     return W_CheckNumForName(namebuf);
 }
 
+static void GetPanning(int vol, int sep, int *left, int *right)
+{
+    *left = ((254 - sep) * vol) / 127;
+    *right = ((sep) * vol) / 127;
+
+    if (*left < 0) *left = 0;
+    else if (*left > 255) *left = 255;
+    if (*right < 0) *right = 0;
+    else if (*right > 255) *right = 255;
+}
+
 static void I_SDL_UpdateSoundParams(int handle, int vol, int sep)
 {
     int left, right;
@@ -900,13 +1804,17 @@ static void I_SDL_UpdateSoundParams(int handle, int vol, int sep)
         return;
     }
 
-    left = ((254 - sep) * vol) / 127;
-    right = ((sep) * vol) / 127;
+    GetPanning(vol, sep, &left, &right);
 
-    if (left < 0) left = 0;
-    else if ( left > 255) left = 255;
-    if (right < 0) right = 0;
-    else if (right > 255) right = 255;
+    if (use_crl_mixer)
+    {
+        // [JN] Same scale as SDL_mixer's panning, 255 to unity.
+        SDL_AtomicLock(&mix_lock);
+        mix_channels[handle].left = (left * 256 + 127) / 255;
+        mix_channels[handle].right = (right * 256 + 127) / 255;
+        SDL_AtomicUnlock(&mix_lock);
+        return;
+    }
 
     Mix_SetPanning(handle, left, right);
 }
@@ -945,42 +1853,69 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
         return -1;
     }
 
-    snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, pitch);
+    // fetch the base sound effect, un-pitch-shifted
 
-    if (snd == NULL)
+    snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
+
+    if (snd_pitchshift && pitch != NORM_PITCH)
     {
-        allocated_sound_t *newsnd;
-        // fetch the base sound effect, un-pitch-shifted
-        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
+        allocated_sound_t *newsnd = PitchCacheFind(sfxinfo, pitch);
 
-        if (snd == NULL)
+        if (newsnd != NULL)
         {
-            return -1;
+            ++pitch_hits;
         }
-
-        if (snd_pitchshift)
+        else
         {
-            newsnd = PitchShift(snd, pitch);
+            ++pitch_misses;
+
+            // Play unshifted this time while the pitch thread makes
+            // the variants.  Without it, shift here as before.
 
-            if (newsnd)
+            if (!RequestPitchSet(snd, pitch))
             {
-                LockAllocatedSound(newsnd);
-                UnlockAllocatedSound(snd);
-                snd = newsnd;
+                newsnd = PitchShift(snd, pitch);
+
+                if (newsnd != NULL)
+                {
+                    PitchCacheInsert(newsnd);
+                }
             }
         }
-    }
-    else
-    {
-        LockAllocatedSound(snd);
+
+        if (newsnd != NULL)
+        {
+            LockAllocatedSound(newsnd);
+            UnlockAllocatedSound(snd);
+            snd = newsnd;
+            PitchCacheTrim();
+        }
     }
 
     // play sound
 
-    Mix_PlayChannel(channel, &snd->chunk, 0);
-
     channels_playing[channel] = snd;
 
+    if (use_crl_mixer)
+    {
+        mix_channel_t *const ch = &mix_channels[channel];
+
+        // [JN] Set the gains first, so it's never mixed with stale ones.
+        I_SDL_UpdateSoundParams(channel, vol, sep);
+
+        SDL_AtomicLock(&mix_lock);
+        ch->snd = snd;
+        ch->pos = 0;
+        ch->delay = 0;
+        ch->start_time = sink_mode ? 0 : SDL_GetPerformanceCounter();
+        ch->done = false;
+        SDL_AtomicUnlock(&mix_lock);
+
+        return channel;
+    }
+
+    Mix_PlayChannel(channel, &snd->chunk, 0);
+
     // set separation, etc.
 
     I_SDL_UpdateSoundParams(channel, vol, sep);
@@ -1009,6 +1944,18 @@ static boolean I_SDL_SoundIsPlaying(int handle)
         return false;
     }
 
+    if (use_crl_mixer)
+    {
+        boolean playing;
+
+        SDL_AtomicLock(&mix_lock);
+        playing = mix_channels[handle].snd != NULL
+              && !mix_channels[handle].done;
+        SDL_AtomicUnlock(&mix_lock);
+
+        return playing;
+    }
+
     return Mix_Playing(handle);
 }
 
@@ -1032,6 +1979,8 @@ static void I_SDL_UpdateSound(void)
             ReleaseSoundOnChannel(i);
         }
     }
+
+    CollectPitchSets();
 }
 
 static void I_SDL_ShutdownSound(void)
@@ -1041,8 +1990,44 @@ static void I_SDL_ShutdownSound(void)
         return;
     }
 
-    Mix_CloseAudio();
-    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    StopPitchThread();
+
+    if (pitch_hits + pitch_misses > 0)
+    {
+        printf("I_SDL_ShutdownSound: Pitch cache: %u hits, %u misses, "
+               "%d KB used.\n", pitch_hits, pitch_misses,
+               pitched_sounds_size / 1024);
+    }
+
+    if (use_crl_mixer && !sink_mode)
+    {
+        Mix_SetPostMix(NULL, NULL);
+
+        if (mix_frames > 0)
+        {
+            const double mixtime = (double) mix_time
+                                 / SDL_GetPerformanceFrequency();
+            const double audiotime = (double) mix_frames / mixer_freq;
+
+            printf("I_SDL_ShutdownSound: Mixer: %u callbacks, "
+                   "%.1f us each, %.3f%% of audio time.\n", mix_callbacks,
+                   mixtime * 1000000.0 / mix_callbacks,
+                   mixtime * 100.0 / audiotime);
+        }
+    }
+
+    use_crl_mixer = false;
+
+    if (!sink_mode)
+    {
+        Mix_CloseAudio();
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+
+    sink_mode = false;
+
+    free(sfxcache_dir);
+    sfxcache_dir = NULL;
 
     sound_initialized = false;
 }
@@ -1055,7 +2040,8 @@ static int GetSliceSize(void)
     int limit;
     int n;
 
-    limit = (snd_samplerate * snd_maxslicetime_ms) / 1000;
+    limit = (snd_samplerate * (snd_crlmixer ? snd_crlmixer_slicetime_ms
+                                            : snd_maxslicetime_ms)) / 1000;
 
     // Try all powers of two, not exceeding the limit.
 
@@ -1086,22 +2072,36 @@ static boolean I_SDL_InitSound(GameMission_t mission)
         channels_playing[i] = NULL;
     }
 
-    if (SDL_Init(SDL_INIT_AUDIO) < 0)
+    // [JN] With -soundsink, there is no audio device: sound effects are
+    // always mixed by our mixer, in the format the sink writes.
+
+    sink_mode = I_SoundSinkActive();
+
+    if (sink_mode)
     {
-        fprintf(stderr, "Unable to set up sound.\n");
-        return false;
+        mixer_freq = snd_samplerate;
+        mixer_format = AUDIO_S16SYS;
+        mixer_channels = 2;
     }
-
-    if (Mix_OpenAudioDevice(snd_samplerate, AUDIO_S16SYS, 2, GetSliceSize(), NULL, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE) < 0)
+    else
     {
-        fprintf(stderr, "Error initialising SDL_mixer: %s\n", Mix_GetError());
-        return false;
+        if (SDL_Init(SDL_INIT_AUDIO) < 0)
+        {
+            fprintf(stderr, "Unable to set up sound.\n");
+            return false;
+        }
+
+        if (Mix_OpenAudioDevice(snd_samplerate, AUDIO_S16SYS, 2, GetSliceSize(), NULL, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE) < 0)
+        {
+            fprintf(stderr, "Error initialising SDL_mixer: %s\n", Mix_GetError());
+            return false;
+        }
+
+        Mix_QuerySpec(&mixer_freq, &mixer_format, &mixer_channels);
     }
 
     ExpandSoundData = ExpandSoundData_SDL;
 
-    Mix_QuerySpec(&mixer_freq, &mixer_format, &mixer_channels);
-
 #ifdef HAVE_LIBSAMPLERATE
     if (use_libsamplerate != 0)
     {
@@ -1122,9 +2122,52 @@ static boolean I_SDL_InitSound(GameMission_t mission)
     }
 #endif
 
-    Mix_AllocateChannels(NUM_CHANNELS);
+    if (snd_sfxcache && strcmp(configdir, "") != 0)
+    {
+        sfxcache_dir = M_StringJoin(configdir, "sfxcache", DIR_SEPARATOR_S,
+                                    NULL);
+        M_MakeDirectory(sfxcache_dir);
+    }
+
+    if (sink_mode)
+    {
+        memset(mix_channels, 0, sizeof(mix_channels));
+        use_crl_mixer = true;
+    }
+    else
+    {
+        Mix_AllocateChannels(NUM_CHANNELS);
+    }
+
+    // [JN] Our mixer only handles the format we ask SDL_mixer for.
+    if (snd_crlmixer && !sink_mode)
+    {
+        if (mixer_format == AUDIO_S16SYS && mixer_channels == 2)
+        {
+            memset(mix_channels, 0, sizeof(mix_channels));
+            mix_time = mix_frames = 0;
+            mix_callbacks = 0;
+            mix_last_callback = 0;
+            mix_exact_start = (snd_crlmixer == 2);
+            use_crl_mixer = true;
+            Mix_SetPostMix(MixCallback, NULL);
+        }
+        else
+        {
+            fprintf(stderr, "I_SDL_InitSound: snd_crlmixer needs 16-bit "
+                            "stereo output, using SDL_mixer channels.\n");
+        }
+    }
 
-    SDL_PauseAudio(0);
+    // Started even with pitch shifting off, as it can be turned on
+    // from the menu.
+
+    StartPitchThread();
+
+    if (!sink_mode)
+    {
+        SDL_PauseAudio(0);
+    }
 
     sound_initialized = true;
 
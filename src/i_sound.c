@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "SDL_mixer.h"
 
@@ -27,9 +28,14 @@
 
 #include "gusconf.h"
 #include "i_sound.h"
+#include "i_swap.h"
+#include "i_system.h"
+#include "i_timer.h"
 #include "i_video.h"
 #include "m_argv.h"
 #include "m_config.h"
+#include "m_misc.h"
+#include "opl.h"
 
 // Sound sample rate to use for digital output (Hz)
 
@@ -40,6 +46,11 @@ int snd_samplerate = 44100;
 
 int snd_cachesize = 64 * 1024 * 1024;
 
+// [JN] Maximum number of bytes to dedicate to pitch-shifted variants of
+// sound effects. (Default: 16MB)
+
+int snd_pitchcachesize = 16 * 1024 * 1024;
+
 // Config variable that controls the sound buffer size.
 // We default to 28ms (1000 / 35fps = 1 buffer per tic).
 
@@ -68,6 +79,19 @@ static boolean music_packs_active = false;
 // depending on whether the current track is substituted.
 static const music_module_t *active_music_module;
 
+// [JN] Sound sink: with -soundsink, sound effects and music are mixed
+// without an audio device, in step with game tics, and written to a
+// WAV file or discarded.  Only games that pump it with I_UpdateSoundSink
+// enable it.
+
+#define SINK_BLOCK 1024
+
+static boolean sink_enabled = false;
+static boolean sink_active = false;
+static FILE *sink_file = NULL;
+static uint64_t sink_tics, sink_frames;
+static uint64_t sink_music_time, sink_sfx_time;
+
 
 // DOS-specific options: These are unused but should be maintained
 // so that the config file can be shared between chocolate
@@ -180,6 +204,14 @@ static void InitMusicModule(void)
             }
         #endif
 
+            // [JN] Without an audio device, only modules that can render
+            // their own output can play.
+
+            if (sink_active && music_modules[i]->Render == NULL)
+            {
+                continue;
+            }
+
             // Initialize the module
 
             if (music_modules[i]->Init())
@@ -188,7 +220,7 @@ static void InitMusicModule(void)
 
             #ifndef DISABLE_SDL2MIXER
                 // [crispy] Always initialize SDL music module.
-                if (music_module != &music_sdl_module)
+                if (music_module != &music_sdl_module && !sink_active)
                 {
                     music_sdl_module.Init();
                 }
@@ -200,6 +232,161 @@ static void InitMusicModule(void)
     }
 }
 
+static void InitSoundSink(void)
+{
+    int p;
+
+    //!
+    // @category obscure
+    // @arg <file>
+    //
+    // Mix sound effects and music without an audio device, in step with
+    // the game, into the given WAV file, or "null" to discard it. Sound
+    // is then kept running under -nodraw, so that benchmarks include
+    // the cost of the sound system. Only music devices that can be
+    // rendered offline (OPL and FluidSynth) are played. Restarting the
+    // sound system, which may change the sample rate, starts the file
+    // over.
+    //
+
+    if (!sink_enabled)
+    {
+        return;
+    }
+
+    p = M_CheckParmWithArgs("-soundsink", 1);
+
+    if (p == 0)
+    {
+        return;
+    }
+
+    // Reopened by every I_InitSound, which truncates the file, so the
+    // counts have to start over with it.
+    sink_tics = sink_frames = 0;
+    sink_music_time = sink_sfx_time = 0;
+
+    if (strcmp(myargv[p + 1], "null") != 0)
+    {
+        sink_file = M_fopen(myargv[p + 1], "wb");
+
+        if (sink_file == NULL)
+        {
+            i_error_safe = true;
+            I_Error("I_InitSound: Unable to open %s", myargv[p + 1]);
+        }
+
+        I_WriteWAVHeader(sink_file, 0, snd_samplerate);
+    }
+
+    // Music is made by rendering it on this thread.
+    OPL_SetOfflineRender(true);
+
+    sink_active = true;
+}
+
+static void ShutdownSoundSink(void)
+{
+    double audiotime, musictime, sfxtime;
+
+    if (!sink_active)
+    {
+        return;
+    }
+
+    if (sink_file != NULL)
+    {
+        I_WriteWAVHeader(sink_file, sink_frames * 4, snd_samplerate);
+        fclose(sink_file);
+        sink_file = NULL;
+    }
+
+    audiotime = (double) sink_frames / snd_samplerate;
+    musictime = (double) sink_music_time / I_GetPerfFrequency();
+    sfxtime = (double) sink_sfx_time / I_GetPerfFrequency();
+
+    printf("I_ShutdownSound: Sound sink: %.1f s of audio, music %.3f s, "
+           "sound effects %.3f s, %.1fx real time.\n", audiotime,
+           musictime, sfxtime,
+           audiotime / (musictime + sfxtime > 0 ? musictime + sfxtime : 1e-9));
+
+    OPL_SetOfflineRender(false);
+
+    sink_active = false;
+}
+
+// [JN] Allow -soundsink; called before I_InitSound by games that call
+// I_UpdateSoundSink from their main loop.
+
+void I_EnableSoundSink(void)
+{
+    sink_enabled = true;
+}
+
+boolean I_SoundSinkActive(void)
+{
+    return sink_active;
+}
+
+// [JN] Produce the audio for the given number of game tics.
+
+void I_UpdateSoundSink(int tics)
+{
+    static int16_t buffer[SINK_BLOCK * 2];
+    uint64_t target, start;
+    int frames, i;
+
+    if (!sink_active)
+    {
+        return;
+    }
+
+    sink_tics += tics;
+    target = sink_tics * snd_samplerate / TICRATE;
+
+    while (sink_frames < target)
+    {
+        frames = target - sink_frames < SINK_BLOCK ?
+                 (int) (target - sink_frames) : SINK_BLOCK;
+
+        start = I_GetPerfCounter();
+
+        if (active_music_module != NULL
+         && active_music_module->Render != NULL)
+        {
+            active_music_module->Render(buffer, frames);
+        }
+        else
+        {
+            memset(buffer, 0, frames * 4);
+        }
+
+        sink_music_time += I_GetPerfCounter() - start;
+        start = I_GetPerfCounter();
+
+#ifndef DISABLE_SDL2MIXER
+        if (sound_module == &sound_sdl_module)
+        {
+            I_SDL_MixSink(buffer, frames);
+        }
+#endif
+
+        sink_sfx_time += I_GetPerfCounter() - start;
+
+        if (sink_file != NULL)
+        {
+            for (i = 0; i < frames * 2; i++)
+            {
+                buffer[i] = SHORT(buffer[i]);
+            }
+
+            fwrite(buffer, 4, frames, sink_file);
+        }
+
+        sink_frames += frames;
+    }
+}
+
 //
 // Initializes sound stuff, including volume
 // Sets channels, SFX and music volume,
@@ -241,6 +428,8 @@ void I_InitSound(GameMission_t mission)
 
     nomusicpacks = M_ParmExists("-nomusicpacks");
 
+    InitSoundSink();
+
     // Auto configure the music pack directory.
     M_SetMusicPackDir();
 
@@ -271,7 +460,7 @@ void I_InitSound(GameMission_t mission)
         }
 
         // We may also have substitute MIDIs we can load.
-        if (!nomusicpacks && music_module != NULL)
+        if (!nomusicpacks && music_module != NULL && !sink_active)
         {
             music_packs_active = music_pack_module.Init();
         }
@@ -286,6 +475,8 @@ void I_InitSound(GameMission_t mission)
 
 void I_ShutdownSound(void)
 {
+    ShutdownSoundSink();
+
     if (sound_module != NULL)
     {
         sound_module->Shutdown();
@@ -504,6 +695,17 @@ void *I_RegisterSong(void *data, int len)
     }
 }
 
+// [JN] Hint that a song is about to be played, so that a music pack
+// substitute for it can be read in ahead of time.
+
+void I_PrefetchSong(void *data, int len)
+{
+    if (music_packs_active && music_pack_module.Prefetch != NULL)
+    {
+        music_pack_module.Prefetch(data, len);
+    }
+}
+
 void I_UnRegisterSong(void *handle)
 {
     if (active_music_module != NULL)
@@ -553,6 +755,7 @@ void I_BindSoundVariables(void)
     M_BindStringVariable("snd_dmxoption",        &snd_dmxoption);
     M_BindIntVariable("snd_samplerate",          &snd_samplerate);
     M_BindIntVariable("snd_cachesize",           &snd_cachesize);
+    M_BindIntVariable("snd_pitchcachesize",      &snd_pitchcachesize);
     M_BindIntVariable("opl_io_port",             &opl_io_port);
     M_BindIntVariable("snd_pitchshift",          &snd_pitchshift);
 
@@ -586,5 +789,8 @@ void I_BindSoundVariables(void)
 
     M_BindIntVariable("use_libsamplerate",       &use_libsamplerate);
     M_BindFloatVariable("libsamplerate_scale",   &libsamplerate_scale);
+    M_BindIntVariable("snd_sfxcache",            &snd_sfxcache);
+    M_BindIntVariable("snd_crlmixer",            &snd_crlmixer);
+    M_BindIntVariable("snd_crlmixer_slicetime_ms", &snd_crlmixer_slicetime_ms);
 }
 
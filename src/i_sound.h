@@ -22,6 +22,8 @@
 #ifndef __I_SOUND__
 #define __I_SOUND__
 
+#include <stdio.h>
+
 #include "doomtype.h"
 #include "d_mode.h"
 
@@ -218,6 +220,16 @@ typedef struct
     // Invoked periodically to poll.
 
     void (*Poll)(void);
+
+    // Synthesise stereo output into a buffer instead of playing it, for
+    // offline rendering.  NULL if the module can't.
+
+    void (*Render)(int16_t *buffer, int frames);
+
+    // Hint that a song is about to be played, so that its data can be
+    // read in ahead of time.  NULL if the module has no use for it.
+
+    void (*Prefetch)(void *data, int len);
 } music_module_t;
 
 void I_InitMusic(void);
@@ -227,6 +239,7 @@ void I_PauseSong(void);
 void I_ResumeSong(void);
 void *I_RegisterSong(void *data, int len);
 void I_UnRegisterSong(void *handle);
+void I_PrefetchSong(void *data, int len);
 void I_PlaySong(void *handle, boolean looping);
 void I_StopSong(void);
 boolean I_MusicIsPlaying(void);
@@ -234,15 +247,27 @@ boolean I_MusicIsPlaying(void);
 boolean IsMid(const byte *mem, int len);
 boolean IsMus(const byte *mem, int len);
 
+void I_RenderMusic(const char *outdir);
+void I_WriteWAVHeader(FILE *wav, uint32_t length, int samplerate);
+
+void I_EnableSoundSink(void);
+boolean I_SoundSinkActive(void);
+void I_UpdateSoundSink(int tics);
+void I_SDL_MixSink(int16_t *buffer, int frames);
+
 extern int snd_sfxdevice;
 extern int snd_musicdevice;
 extern int snd_samplerate;
 extern int snd_cachesize;
+extern int snd_pitchcachesize;
 extern int snd_maxslicetime_ms;
 extern char *snd_musiccmd;
 extern int snd_pitchshift;
 extern char *snd_dmxoption;
 extern int use_libsamplerate;
+extern int snd_sfxcache;
+extern int snd_crlmixer;
+extern int snd_crlmixer_slicetime_ms;
 extern float libsamplerate_scale;
 
 void I_BindSoundVariables(void);
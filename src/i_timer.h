@@ -38,9 +38,16 @@ int I_GetTimeMS (void);
 // returns current time in us
 uint64_t I_GetTimeUS(void); // [crispy]
 
+// [JN] Raw high-resolution counter and its frequency, for profiling
+uint64_t I_GetPerfCounter(void);
+uint64_t I_GetPerfFrequency(void);
+
 // Pause for a specified number of ms
 void I_Sleep(int ms);
 
+// [JN] Pause for a specified number of us, with sub-millisecond precision
+void I_SleepUS(uint64_t us);
+
 // Initialize timer
 void I_InitTimer(void);
 
@@ -36,6 +36,7 @@
 #include "d_loop.h"
 #include "deh_str.h"
 #include "doomtype.h"
+#include "i_capture.h"
 #include "i_input.h"
 #include "i_joystick.h"
 #include "i_system.h"
@@ -89,8 +90,19 @@ static SDL_Rect blit_rect = {
 // palette
 
 static SDL_Color palette[256];
+
+// [JN] Palette as RGB triplets for the gameplay capture.
+static byte capture_palette[256 * 3];
 static boolean palette_to_set;
 
+// [JN] Palette as ARGB8888 texels, expanded straight into the texture.
+static uint32_t palette_argb[256];
+
+// [JN] Copy of the last frame uploaded to the texture. Unchanged frames
+// (pause, static menus with uncapped framerate) skip the upload.
+static pixel_t blit_lastframe[SCREENWIDTH * SCREENHEIGHT];
+static boolean blit_force;
+
 // display has been set up?
 
 static boolean initialized = false;
@@ -623,6 +635,12 @@ static void I_GetEvent(void)
                 }
                 break;
 
+            // [JN] Texture contents may be lost, upload the next frame.
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                blit_force = true;
+                break;
+
             default:
                 break;
         }
@@ -849,6 +867,129 @@ static void CreateUpscaledTexture(boolean force)
     }
 }
 
+// -----------------------------------------------------------------------------
+// I_ExpandFrame
+//  [JN] Converts the paletted screen buffer into ARGB8888 texels, replacing
+//  SDL_LowerBlit. A plain table lookup; frames that did not change are
+//  skipped by the caller.
+// -----------------------------------------------------------------------------
+
+static void I_ExpandFrame (const pixel_t *src, byte *dest, int pitch)
+{
+    const uint32_t *const pal = palette_argb;
+    int y;
+
+    for (y = 0 ; y < SCREENHEIGHT ; y++)
+    {
+        uint32_t *out = (uint32_t *) (dest + y * pitch);
+        const pixel_t *in = src + y * SCREENWIDTH;
+        int x;
+
+        for (x = 0 ; x < SCREENWIDTH ; x++)
+        {
+            out[x] = pal[in[x]];
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// I_PaceFrame
+//  [JN] Holds the framerate limit. Frames are scheduled against absolute
+//  deadlines, so a late frame is made up by the next one instead of
+//  shifting the whole schedule. Most of the wait is spent in a
+//  high-resolution sleep, only the last few hundred microseconds are
+//  spun, widened if the system timer proves to oversleep.
+// -----------------------------------------------------------------------------
+
+#define PACE_MINSPIN  250   // us
+#define PACE_MAXSPIN  4000  // us
+
+static void I_PaceFrame (int rate)
+{
+    static uint64_t deadline;
+    static uint64_t spin = PACE_MINSPIN;
+    const uint64_t period = 1000000ull / rate;
+    uint64_t now = I_GetTimeUS();
+
+    deadline += period;
+
+    // More than a frame behind (first frame, loading, window dragging)
+    // or the limit was lowered: restart the schedule from now instead
+    // of rushing through the missed frames.
+    if (now > deadline + period || deadline > now + period)
+    {
+        deadline = now;
+        return;
+    }
+
+    if (deadline > now + spin)
+    {
+        const uint64_t request = deadline - now - spin;
+        uint64_t overshoot;
+
+        I_SleepUS(request);
+        now = I_GetTimeUS();
+
+        // Keep the spin just above the observed oversleep, and let it
+        // slowly settle back when the timer behaves.
+        overshoot = now > deadline - spin ? now - (deadline - spin) : 0;
+
+        if (overshoot + PACE_MINSPIN > spin)
+        {
+            spin = MIN(overshoot + PACE_MINSPIN, PACE_MAXSPIN);
+        }
+        else
+        {
+            spin -= (spin - PACE_MINSPIN) / 16;
+        }
+    }
+
+    while (now < deadline)
+    {
+        now = I_GetTimeUS();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// I_UpdatePacingStats
+//  [JN] Measures achieved frame intervals: average, standard deviation
+//  (jitter) and worst, updated every quarter of a second like the FPS
+//  counter.
+// -----------------------------------------------------------------------------
+
+static void I_UpdatePacingStats (void)
+{
+    static uint64_t last, window_start;
+    static uint64_t sum, sumsq, worst;
+    static int count;
+    const uint64_t now = I_GetTimeUS();
+
+    if (last != 0)
+    {
+        const uint64_t interval = now - last;
+
+        sum += interval;
+        sumsq += interval * interval;
+        worst = MAX(worst, interval);
+        count++;
+    }
+    last = now;
+
+    if (now - window_start >= 250000 && count > 0)
+    {
+        const double avg = (double) sum / count;
+        const double var = (double) sumsq / count - avg * avg;
+
+        CRL_frametime = (int) avg;
+        CRL_frametime_jitter = var > 0 ? (int) sqrt(var) : 0;
+        CRL_frametime_worst = (int) worst;
+
+        sum = sumsq = worst = 0;
+        count = 0;
+        window_start = now;
+    }
+}
+
 //
 // I_FinishUpdate
 //
@@ -944,6 +1085,31 @@ void I_FinishUpdate (void)
         SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
         palette_to_set = false;
 
+        {
+            int i;
+
+            for (i = 0 ; i < 256 ; i++)
+            {
+                palette_argb[i] = 0xff000000u
+                                | ((uint32_t) palette[i].r << 16)
+                                | ((uint32_t) palette[i].g << 8)
+                                |  (uint32_t) palette[i].b;
+            }
+        }
+        blit_force = true;
+
+        if (capture_active)
+        {
+            int i;
+
+            for (i = 0 ; i < 256 ; i++)
+            {
+                capture_palette[i * 3 + 0] = palette[i].r;
+                capture_palette[i * 3 + 1] = palette[i].g;
+                capture_palette[i * 3 + 2] = palette[i].b;
+            }
+        }
+
         if (vga_porch_flash)
         {
             // "flash" the pillars/letterboxes with palette changes, emulating
@@ -953,14 +1119,27 @@ void I_FinishUpdate (void)
         }
     }
 
-    // Blit from the paletted 8-bit screen buffer to the intermediate
-    // 32-bit RGBA buffer and update the intermediate texture with the
-    // contents of the RGBA buffer.
+    // [JN] Hand the native frame over to the capture writer.
+    if (capture_active)
+    {
+        I_CaptureFrame(I_VideoBuffer, capture_palette);
+    }
+
+    // Expand the paletted 8-bit screen buffer into the intermediate
+    // 32-bit texture. [JN] Frames identical to the last uploaded one
+    // are skipped, the texture still holds them.
+
+    if (blit_force
+    ||  memcmp(blit_lastframe, I_VideoBuffer, sizeof(blit_lastframe)) != 0)
+    {
+        memcpy(blit_lastframe, I_VideoBuffer, sizeof(blit_lastframe));
+        blit_force = false;
 
-    SDL_LockTexture(texture, &blit_rect, &argbbuffer->pixels,
-                    &argbbuffer->pitch);
-    SDL_LowerBlit(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
-    SDL_UnlockTexture(texture);
+        SDL_LockTexture(texture, &blit_rect, &argbbuffer->pixels,
+                        &argbbuffer->pitch);
+        I_ExpandFrame(I_VideoBuffer, argbbuffer->pixels, argbbuffer->pitch);
+        SDL_UnlockTexture(texture);
+    }
 
     // Make sure the pillarboxes are kept clear each frame.
 
@@ -994,31 +1173,12 @@ void I_FinishUpdate (void)
         // Limit framerate
         if (crl_fpslimit >= TICRATE)
         {
-            uint64_t target_time = 1000000ull / crl_fpslimit;
-            static uint64_t start_time;
-
-            while (1)
-            {
-                uint64_t current_time = I_GetTimeUS();
-                uint64_t elapsed_time = current_time - start_time;
-                uint64_t remaining_time = 0;
-
-                if (elapsed_time >= target_time)
-                {
-                    start_time = current_time;
-                    break;
-                }
-
-                remaining_time = target_time - elapsed_time;
-
-                if (remaining_time > 1000)
-                {
-                    I_Sleep((remaining_time - 1000) / 1000);
-                }
-            }
+            I_PaceFrame(crl_fpslimit);
         }
     }
 
+    I_UpdatePacingStats();
+
     // Restore background and undo the disk indicator, if it was drawn.
     V_RestoreDiskBackground();
 }
@@ -1050,9 +1210,27 @@ static const double colorblind_matrix[][3][3] = {
     { {0.61800, 0.32000, 0.06200}, {0.16300, 0.77500, 0.06200}, {0.16300, 0.32000, 0.51600} }, // Achromatomaly
 };
 
+//
+// I_GetPalette
+// [JN] Current palette as RGB triplets, for native screenshots.
+//
+
+void I_GetPalette (byte *rgb)
+{
+    int i;
+
+    for (i = 0 ; i < 256 ; i++)
+    {
+        *rgb++ = palette[i].r;
+        *rgb++ = palette[i].g;
+        *rgb++ = palette[i].b;
+    }
+}
+
 //
 // I_SetPalette
 //
+
 void I_SetPalette (const byte *doompalette)
 {
     int i;
@@ -1248,6 +1426,37 @@ void I_GraphicsCheckCommandLine(void)
         fullscreen = true;
     }
 
+    //!
+    // @category video
+    // @arg <file>
+    //
+    // Record every presented frame losslessly, at the native resolution
+    // and with palette changes, to the specified file.
+    //
+
+    i = M_CheckParmWithArgs("-capture", 1);
+
+    if (i > 0)
+    {
+        I_StartCapture(myargv[i + 1]);
+    }
+
+    //!
+    // @category video
+    // @arg <file> <dir>
+    //
+    // Export the frames of a file recorded with -capture as PNG
+    // images into the specified directory, then quit.
+    //
+
+    i = M_CheckParmWithArgs("-captureexport", 2);
+
+    if (i > 0)
+    {
+        I_CaptureExport(myargv[i + 1], myargv[i + 2]);
+        I_Quit();
+    }
+
     //!
     // @category video 
     //
@@ -1597,6 +1806,7 @@ static void SetVideoMode(void)
                                 SDL_PIXELFORMAT_ARGB8888,
                                 SDL_TEXTUREACCESS_STREAMING,
                                 SCREENWIDTH, SCREENHEIGHT);
+    blit_force = true;
 
     // [JN] Workaround for SDL 2.0.14+ alt-tab bug
 #if defined(_WIN32)
@@ -54,6 +54,7 @@ void I_RenderReadPixels (byte **data, int *w, int *h);
 
 // Takes full 8 bit values.
 void I_SetPalette (const byte* doompalette);
+void I_GetPalette (byte *rgb);
 int I_GetPaletteIndex(int r, int g, int b);
 
 void I_FinishUpdate (void);
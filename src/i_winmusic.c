@@ -1899,6 +1899,8 @@ const music_module_t music_win_module =
     I_WIN_StopSong,
     I_WIN_MusicIsPlaying,
     NULL,  // Poll
+    NULL,  // Render
+    NULL,  // Prefetch
 };
 
 #endif
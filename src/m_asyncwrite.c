@@ -0,0 +1,208 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Background file writer. Writes a finished memory buffer to a
+//	temporary file, flushes it to disk and renames it over the real
+//	file on a separate thread, so slow disks do not stall the game.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "SDL.h"
+
+#include "i_system.h"
+#include "m_asyncwrite.h"
+#include "m_misc.h"
+
+
+static SDL_Thread *writer_thread = NULL;
+static SDL_atomic_t writer_state;
+
+// A failed write that was not polled before the next write started.
+static boolean writer_unreported_failure = false;
+
+static char *writer_tempname;
+static char *writer_filename;
+static byte *writer_data;
+static size_t writer_len;
+
+static boolean WriteAndSync (void)
+{
+    FILE *file;
+    boolean ok;
+
+    file = M_fopen(writer_tempname, "wb");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    ok = fwrite(writer_data, 1, writer_len, file) == writer_len
+      && fflush(file) == 0;
+
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+
+    ok = (fclose(file) == 0) && ok;
+
+    return ok;
+}
+
+static int WriterThread (void *unused)
+{
+    boolean ok = WriteAndSync();
+
+    if (ok)
+    {
+        M_remove(writer_filename);
+        ok = M_rename(writer_tempname, writer_filename) == 0;
+    }
+
+    SDL_AtomicSet(&writer_state, ok ? ASYNCWRITE_DONE : ASYNCWRITE_FAILED);
+
+    return 0;
+}
+
+// Release the finished thread and its buffer.
+
+static void ReapWriter (void)
+{
+    if (writer_thread != NULL)
+    {
+        SDL_WaitThread(writer_thread, NULL);
+        writer_thread = NULL;
+
+        free(writer_data);
+        free(writer_tempname);
+        free(writer_filename);
+        writer_data = NULL;
+        writer_tempname = NULL;
+        writer_filename = NULL;
+    }
+}
+
+//
+// M_AsyncWriteFile
+//  Takes ownership of data (allocated with malloc) and starts writing it.
+//  Waits for a previous write to finish first. If no thread can be
+//  created, the file is written right away. Returns false only if that
+//  immediate write fails, which is then not reported by M_AsyncWritePoll;
+//  success is, as for a background write.
+//
+
+boolean M_AsyncWriteFile (const char *tempname, const char *filename,
+                          byte *data, size_t len)
+{
+    static boolean atexit_set = false;
+
+    // Do not quit with a savegame half written.
+    if (!atexit_set)
+    {
+        I_AtExit(M_AsyncWriteWait, true);
+        atexit_set = true;
+    }
+
+    M_AsyncWriteWait();
+
+    // The previous result is about to be overwritten; don't lose a
+    // failure, M_AsyncWritePoll reports it first.
+    if (SDL_AtomicGet(&writer_state) == ASYNCWRITE_FAILED)
+    {
+        writer_unreported_failure = true;
+    }
+
+    writer_tempname = M_StringDuplicate(tempname);
+    writer_filename = M_StringDuplicate(filename);
+    writer_data = data;
+    writer_len = len;
+
+    SDL_AtomicSet(&writer_state, ASYNCWRITE_BUSY);
+
+    writer_thread = SDL_CreateThread(WriterThread, "savewriter", NULL);
+
+    if (writer_thread == NULL)
+    {
+        boolean ok;
+
+        WriterThread(NULL);
+        ok = SDL_AtomicGet(&writer_state) == ASYNCWRITE_DONE;
+
+        if (!ok)
+        {
+            SDL_AtomicSet(&writer_state, ASYNCWRITE_IDLE);
+        }
+
+        free(writer_data);
+        free(writer_tempname);
+        free(writer_filename);
+        writer_data = NULL;
+        writer_tempname = NULL;
+        writer_filename = NULL;
+
+        return ok;
+    }
+
+    return true;
+}
+
+//
+// M_AsyncWritePoll
+//  Returns the result of the last write once, then ASYNCWRITE_IDLE.
+//  A failure of an earlier write that was never polled comes first.
+//
+
+asyncwrite_t M_AsyncWritePoll (void)
+{
+    asyncwrite_t state;
+
+    if (writer_unreported_failure)
+    {
+        writer_unreported_failure = false;
+        return ASYNCWRITE_FAILED;
+    }
+
+    state = SDL_AtomicGet(&writer_state);
+
+    if (state == ASYNCWRITE_DONE || state == ASYNCWRITE_FAILED)
+    {
+        ReapWriter();
+        SDL_AtomicSet(&writer_state, ASYNCWRITE_IDLE);
+    }
+
+    return state;
+}
+
+//
+// M_AsyncWriteWait
+//  Blocks until the current write, if any, is on disk. The result is
+//  still reported by the next M_AsyncWritePoll.
+//
+
+void M_AsyncWriteWait (void)
+{
+    ReapWriter();
+}
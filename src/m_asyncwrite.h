@@ -0,0 +1,37 @@
+//
+// Copyright(C) 2026 Julia Nechaevskaya
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Background file writer.
+//
+
+
+#ifndef __M_ASYNCWRITE__
+#define __M_ASYNCWRITE__
+
+#include "doomtype.h"
+
+typedef enum
+{
+    ASYNCWRITE_IDLE,     // Nothing written since the last poll.
+    ASYNCWRITE_BUSY,     // A write is still in progress.
+    ASYNCWRITE_DONE,     // The file was written and renamed into place.
+    ASYNCWRITE_FAILED,   // Temporary file could not be written.
+} asyncwrite_t;
+
+boolean M_AsyncWriteFile(const char *tempname, const char *filename,
+                         byte *data, size_t len);
+asyncwrite_t M_AsyncWritePoll(void);
+void M_AsyncWriteWait(void);
+
+#endif
@@ -246,6 +246,7 @@ static default_t	doom_defaults_list[] =
     CONFIG_VARIABLE_STRING(screenshots_format),
     CONFIG_VARIABLE_INT(screenshots_png_compression),
     CONFIG_VARIABLE_INT(screenshots_jpg_quality),
+    CONFIG_VARIABLE_INT(screenshots_native),
     CONFIG_VARIABLE_COMMENT(""),
 
     //
@@ -338,8 +339,12 @@ static default_t	doom_defaults_list[] =
 #endif
     CONFIG_VARIABLE_INT(use_libsamplerate),
     CONFIG_VARIABLE_FLOAT(libsamplerate_scale),
+    CONFIG_VARIABLE_INT(snd_sfxcache),
+    CONFIG_VARIABLE_INT(snd_crlmixer),
+    CONFIG_VARIABLE_INT(snd_crlmixer_slicetime_ms),
     CONFIG_VARIABLE_INT(snd_samplerate),
     CONFIG_VARIABLE_INT(snd_cachesize),
+    CONFIG_VARIABLE_INT(snd_pitchcachesize),
     CONFIG_VARIABLE_INT(snd_maxslicetime_ms),
     CONFIG_VARIABLE_COMMENT(""),
 
@@ -608,6 +613,7 @@ static default_t	doom_defaults_list[] =
     CONFIG_VARIABLE_INT(crl_widget_speed),
     CONFIG_VARIABLE_INT(crl_widget_powerups),
     CONFIG_VARIABLE_INT(crl_widget_health),
+    CONFIG_VARIABLE_INT(crl_widget_thinkers),
     CONFIG_VARIABLE_COMMENT(""),
 
     // Automap
@@ -670,6 +676,12 @@ static default_t	doom_defaults_list[] =
     CONFIG_VARIABLE_INT(crl_unknown_linedefs),
     CONFIG_VARIABLE_INT(vanilla_savegame_limit),
     CONFIG_VARIABLE_INT(crl_vanilla_limits),
+    CONFIG_VARIABLE_COMMENT(""),
+
+    // Performance
+
+    CONFIG_VARIABLE_COMMENT("Performance"),
+    CONFIG_VARIABLE_INT(crl_sight_cache),
 };
 
 static default_collection_t doom_defaults =
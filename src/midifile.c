@@ -86,11 +86,23 @@ struct midi_file_s
     midi_track_t *tracks;
     unsigned int num_tracks;
 
-    // Data buffer used to store data read for SysEx or meta events:
-    byte *buffer;
-    unsigned int buffer_size;
+    // [JN] Single block holding the track list, then the events of all
+    // tracks back to back, then the SysEx and meta event data.
+    void *arena;
 };
 
+// [JN] Where the next event and data bytes go while tracks are read.
+// The file is read twice: first with NULL pointers, only to count how
+// much space the tracks need, then again to fill in the arena.
+
+typedef struct
+{
+    midi_event_t *events;
+    byte *bytes;
+    unsigned int num_events;
+    size_t num_bytes;
+} midi_arena_t;
+
 // Check the header of a chunk:
 
 static boolean CheckChunkHeader(const chunk_header_t *chunk,
@@ -163,31 +175,38 @@ static boolean ReadVariableLength(unsigned int *result, MEMFILE *stream)
 
 // Read a byte sequence into the data buffer.
 
-static void *ReadByteSequence(unsigned int num_bytes, MEMFILE *stream)
+static boolean ReadByteSequence(byte **result, unsigned int num_bytes,
+                                MEMFILE *stream, midi_arena_t *arena)
 {
-    byte *result;
+    // [JN] Just skip over the data while counting.
 
-    // Allocate a buffer. Allocate one extra byte, as malloc(0) is
-    // non-portable.
+    if (arena->bytes == NULL)
+    {
+        *result = NULL;
+        arena->num_bytes += num_bytes;
 
-    result = malloc(num_bytes + 1);
+        if (mem_fseek(stream, num_bytes, MEM_SEEK_CUR) < 0)
+        {
+            fprintf(stderr, "ReadByteSequence: Error while reading data\n");
+            return false;
+        }
 
-    if (result == NULL)
-    {
-        fprintf(stderr, "ReadByteSequence: Failed to allocate buffer\n");
-        return NULL;
+        return true;
     }
 
     // Read the data:
 
-    if (mem_fread(result, 1, num_bytes, stream) < num_bytes)
+    *result = arena->bytes;
+
+    if (mem_fread(*result, 1, num_bytes, stream) < num_bytes)
     {
         fprintf(stderr, "ReadByteSequence: Error while reading data\n");
-        free(result);
-        return NULL;
+        return false;
     }
 
-    return result;
+    arena->bytes += num_bytes;
+
+    return true;
 }
 
 // Read a MIDI channel event.
@@ -236,7 +255,7 @@ static boolean ReadChannelEvent(midi_event_t *event,
 // Read sysex event:
 
 static boolean ReadSysExEvent(midi_event_t *event, int event_type,
-                              MEMFILE *stream)
+                              MEMFILE *stream, midi_arena_t *arena)
 {
     event->event_type = event_type;
 
@@ -249,9 +268,8 @@ static boolean ReadSysExEvent(midi_event_t *event, int event_type,
 
     // Read the byte sequence:
 
-    event->data.sysex.data = ReadByteSequence(event->data.sysex.length, stream);
-
-    if (event->data.sysex.data == NULL)
+    if (!ReadByteSequence(&event->data.sysex.data, event->data.sysex.length,
+                          stream, arena))
     {
         fprintf(stderr, "ReadSysExEvent: Failed while reading SysEx event\n");
         return false;
@@ -262,7 +280,8 @@ static boolean ReadSysExEvent(midi_event_t *event, int event_type,
 
 // Read meta event:
 
-static boolean ReadMetaEvent(midi_event_t *event, MEMFILE *stream)
+static boolean ReadMetaEvent(midi_event_t *event, MEMFILE *stream,
+                             midi_arena_t *arena)
 {
     byte b = 0;
 
@@ -289,9 +308,8 @@ static boolean ReadMetaEvent(midi_event_t *event, MEMFILE *stream)
 
     // Read the byte sequence:
 
-    event->data.meta.data = ReadByteSequence(event->data.meta.length, stream);
-
-    if (event->data.meta.data == NULL)
+    if (!ReadByteSequence(&event->data.meta.data, event->data.meta.length,
+                          stream, arena))
     {
         fprintf(stderr, "ReadSysExEvent: Failed while reading SysEx event\n");
         return false;
@@ -301,7 +319,7 @@ static boolean ReadMetaEvent(midi_event_t *event, MEMFILE *stream)
 }
 
 static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
-                         MEMFILE *stream)
+                         MEMFILE *stream, midi_arena_t *arena)
 {
     byte event_type = 0;
 
@@ -366,10 +384,10 @@ static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     {
         case MIDI_EVENT_SYSEX:
         case MIDI_EVENT_SYSEX_SPLIT:
-            return ReadSysExEvent(event, event_type, stream);
+            return ReadSysExEvent(event, event_type, stream, arena);
 
         case MIDI_EVENT_META:
-            return ReadMetaEvent(event, stream);
+            return ReadMetaEvent(event, stream, arena);
 
         default:
             break;
@@ -379,30 +397,6 @@ static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     return false;
 }
 
-// Free an event:
-
-static void FreeEvent(midi_event_t *event)
-{
-    // Some event types have dynamically allocated buffers assigned
-    // to them that must be freed.
-
-    switch (event->event_type)
-    {
-        case MIDI_EVENT_SYSEX:
-        case MIDI_EVENT_SYSEX_SPLIT:
-            free(event->data.sysex.data);
-            break;
-
-        case MIDI_EVENT_META:
-            free(event->data.meta.data);
-            break;
-
-        default:
-            // Nothing to do.
-            break;
-    }
-}
-
 // Read and check the track chunk header
 
 static boolean ReadTrackHeader(midi_track_t *track, MEMFILE *stream)
@@ -424,14 +418,15 @@ static boolean ReadTrackHeader(midi_track_t *track, MEMFILE *stream)
     return true;
 }
 
-static boolean ReadTrack(midi_track_t *track, MEMFILE *stream)
+static boolean ReadTrack(midi_track_t *track, MEMFILE *stream,
+                         midi_arena_t *arena)
 {
-    midi_event_t *new_events;
+    midi_event_t scratch;
     midi_event_t *event;
     unsigned int last_event_type;
 
     track->num_events = 0;
-    track->events = NULL;
+    track->events = arena->events;
 
     // Read the header:
 
@@ -446,21 +441,22 @@ static boolean ReadTrack(midi_track_t *track, MEMFILE *stream)
 
     for (;;)
     {
-        // Resize the track slightly larger to hold another event:
+        // Read the next event, into the arena unless counting:
 
-        new_events = I_Realloc(track->events, 
-                             sizeof(midi_event_t) * (track->num_events + 1));
-        track->events = new_events;
+        event = arena->events != NULL ? arena->events : &scratch;
 
-        // Read the next event:
-
-        event = &track->events[track->num_events];
-        if (!ReadEvent(event, &last_event_type, stream))
+        if (!ReadEvent(event, &last_event_type, stream, arena))
         {
             return false;
         }
 
         ++track->num_events;
+        ++arena->num_events;
+
+        if (arena->events != NULL)
+        {
+            ++arena->events;
+        }
 
         // End of track?
 
@@ -474,40 +470,49 @@ static boolean ReadTrack(midi_track_t *track, MEMFILE *stream)
     return true;
 }
 
-// Free a track:
-
-static void FreeTrack(midi_track_t *track)
+static boolean ReadAllTracks(midi_file_t *file, MEMFILE *stream)
 {
+    midi_arena_t arena = {0};
+    const long start = mem_ftell(stream);
+    midi_track_t scratch;
+    size_t tracks_size, events_size;
     unsigned int i;
 
-    for (i=0; i<track->num_events; ++i)
+    // [JN] Count the events and data bytes in all tracks:
+
+    for (i=0; i<file->num_tracks; ++i)
     {
-        FreeEvent(&track->events[i]);
+        if (!ReadTrack(&scratch, stream, &arena))
+        {
+            return false;
+        }
     }
 
-    free(track->events);
-}
-
-static boolean ReadAllTracks(midi_file_t *file, MEMFILE *stream)
-{
-    unsigned int i;
+    // Allocate space for all of them at once. Allocate one extra byte,
+    // so that zero-length data still gets a valid pointer.
 
-    // Allocate list of tracks and read each track:
+    tracks_size = sizeof(midi_track_t) * file->num_tracks;
+    events_size = sizeof(midi_event_t) * arena.num_events;
 
-    file->tracks = malloc(sizeof(midi_track_t) * file->num_tracks);
+    file->arena = malloc(tracks_size + events_size + arena.num_bytes + 1);
 
-    if (file->tracks == NULL)
+    if (file->arena == NULL)
     {
+        fprintf(stderr, "ReadAllTracks: Failed to allocate buffer\n");
         return false;
     }
 
-    memset(file->tracks, 0, sizeof(midi_track_t) * file->num_tracks);
+    file->tracks = file->arena;
+    arena.events = (midi_event_t *) ((byte *) file->arena + tracks_size);
+    arena.bytes = (byte *) file->arena + tracks_size + events_size;
 
-    // Read each track:
+    // Read each track into it:
+
+    mem_fseek(stream, start, MEM_SEEK_SET);
 
     for (i=0; i<file->num_tracks; ++i)
     {
-        if (!ReadTrack(&file->tracks[i], stream))
+        if (!ReadTrack(&file->tracks[i], stream, &arena))
         {
             return false;
         }
@@ -641,18 +646,7 @@ boolean MIDI_CheckFile(void *data, int len)
 
 void MIDI_FreeFile(midi_file_t *file)
 {
-    int i;
-
-    if (file->tracks != NULL)
-    {
-        for (i=0; i<file->num_tracks; ++i)
-        {
-            FreeTrack(&file->tracks[i]);
-        }
-
-        free(file->tracks);
-    }
-
+    free(file->arena);
     free(file);
 }
 
@@ -669,8 +663,7 @@ static midi_file_t *CreateMIDIFile(void)
 
     file->tracks = NULL;
     file->num_tracks = 0;
-    file->buffer = NULL;
-    file->buffer_size = 0;
+    file->arena = NULL;
 
     return file;
 }
@@ -25,6 +25,8 @@
 #include <string.h>
 #include <math.h>
 
+#include "SDL.h"
+
 #define MINIZ_NO_STDIO
 #define MINIZ_NO_ZLIB_APIS
 #include "miniz.h"
@@ -645,37 +647,129 @@ void V_RestoreBuffer(void)
 //
 
 
+// [JN] Screenshots are read back on the game thread and handed to a
+// worker thread for encoding and writing. At most MAXSHOTJOBS may be in
+// flight, taking another one waits for the oldest to finish.
+
+#define MAXSHOTJOBS 4
+
+typedef struct
+{
+    char       *filename;
+    byte       *data;       // RGBA, or palette indexes if native
+    int         width;
+    int         height;
+    boolean     native;
+    boolean     jpeg;
+    int         level;      // PNG compression or JPEG quality
+    byte        palette[256 * 3];
+    int         sequence;
+    SDL_Thread *thread;
+    SDL_atomic_t done;
+} shotjob_t;
+
+static shotjob_t shotjobs[MAXSHOTJOBS];
+static int shot_sequence;
+
 //
 // WritePNGfile
 //
 
-static void WritePNGfile (const char *filename)
+static void WritePNGfile (const shotjob_t *job)
 {
-    byte *data;
-    int width, height;
     size_t png_data_size = 0;
 
-    I_RenderReadPixels(&data, &width, &height);
+    // [PN] Using the _ex version to explicitly set compression level
+    // (screenshots_png_compression) and vertical flip (MZ_FALSE = do not flip).
+    void *pPNG_data = tdefl_write_image_to_png_file_in_memory_ex(
+              job->data, job->width, job->height, 4, &png_data_size, job->level, MZ_FALSE);
+
+    if (pPNG_data != NULL)
     {
-        // [PN] Using the _ex version to explicitly set compression level
-        // (screenshots_png_compression) and vertical flip (MZ_FALSE = do not flip).
-        void *pPNG_data = tdefl_write_image_to_png_file_in_memory_ex(
-                  data, width, height, 4, &png_data_size, screenshots_png_compression, MZ_FALSE);
+        FILE *handle = M_fopen(job->filename, "wb");
 
-        if (!pPNG_data)
+        if (handle != NULL)
         {
-            return;
-        }
-        else
-        {
-            FILE *handle = M_fopen(filename, "wb");
             fwrite(pPNG_data, 1, png_data_size, handle);
             fclose(handle);
-            mz_free(pPNG_data);
         }
+        mz_free(pPNG_data);
     }
+}
+
+// -----------------------------------------------------------------------------
+// WriteIndexedPNGfile
+//  [JN] Saves the native screen buffer as an 8-bit paletted PNG.
+// -----------------------------------------------------------------------------
 
-    free(data);
+static void WritePNGChunk (FILE *handle, const char *type,
+                           const byte *data, size_t len)
+{
+    byte buf[4];
+    mz_ulong crc;
+
+    buf[0] = (len >> 24) & 0xff;
+    buf[1] = (len >> 16) & 0xff;
+    buf[2] = (len >> 8) & 0xff;
+    buf[3] = len & 0xff;
+    fwrite(buf, 1, 4, handle);
+    fwrite(type, 1, 4, handle);
+    fwrite(data, 1, len, handle);
+
+    crc = mz_crc32(MZ_CRC32_INIT, (const byte *) type, 4);
+    crc = mz_crc32(crc, data, len);
+    buf[0] = (crc >> 24) & 0xff;
+    buf[1] = (crc >> 16) & 0xff;
+    buf[2] = (crc >> 8) & 0xff;
+    buf[3] = crc & 0xff;
+    fwrite(buf, 1, 4, handle);
+}
+
+static void WriteIndexedPNGfile (const shotjob_t *job)
+{
+    static const byte signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    const size_t rowsize = job->width + 1;
+    const size_t rawsize = rowsize * job->height;
+    size_t compsize = 0;
+    byte ihdr[13];
+    byte *raw, *comp;
+    FILE *handle;
+    int y;
+
+    raw = malloc(rawsize);
+
+    // Every scanline starts with filter type 0, no filtering.
+    for (y = 0 ; y < job->height ; y++)
+    {
+        raw[y * rowsize] = 0;
+        memcpy(raw + y * rowsize + 1, job->data + y * job->width, job->width);
+    }
+
+    // Window bits 15 makes it a zlib stream, as IDAT wants.
+    comp = tdefl_compress_mem_to_heap(raw, rawsize, &compsize,
+               tdefl_create_comp_flags_from_zip_params(job->level, 15,
+                                                       MZ_DEFAULT_STRATEGY));
+
+    if (comp != NULL && (handle = M_fopen(job->filename, "wb")) != NULL)
+    {
+        memset(ihdr, 0, sizeof(ihdr));
+        ihdr[2] = (job->width >> 8) & 0xff;
+        ihdr[3] = job->width & 0xff;
+        ihdr[6] = (job->height >> 8) & 0xff;
+        ihdr[7] = job->height & 0xff;
+        ihdr[8] = 8;    // bit depth
+        ihdr[9] = 3;    // indexed color
+
+        fwrite(signature, 1, sizeof(signature), handle);
+        WritePNGChunk(handle, "IHDR", ihdr, sizeof(ihdr));
+        WritePNGChunk(handle, "PLTE", job->palette, sizeof(job->palette));
+        WritePNGChunk(handle, "IDAT", comp, compsize);
+        WritePNGChunk(handle, "IEND", NULL, 0);
+        fclose(handle);
+    }
+
+    free(raw);
+    mz_free(comp);
 }
 
 // -----------------------------------------------------------------------------
@@ -703,15 +797,26 @@ static void stbi_write_fwrite_callback(void *context, void *data, int size)
 //  and a loop over all pixels.
 // -----------------------------------------------------------------------------
 
-static void WriteJPEGfile(const char *filename)
+static void WriteJPEGfile (const shotjob_t *job)
 {
-    byte *data;
-    int   width, height;
     FILE *handle;
+    byte *rgb = NULL;
+
+    // [JN] Native buffer has to be expanded through its palette first.
+    if (job->native)
+    {
+        const int size = job->width * job->height;
+        int i;
+
+        rgb = malloc(size * 3);
 
-    I_RenderReadPixels(&data, &width, &height);
+        for (i = 0 ; i < size ; i++)
+        {
+            memcpy(rgb + i * 3, job->palette + job->data[i] * 3, 3);
+        }
+    }
 
-    handle = M_fopen(filename, "wb");
+    handle = M_fopen(job->filename, "wb");
 
     if (handle != NULL)
     {
@@ -719,15 +824,98 @@ static void WriteJPEGfile(const char *filename)
         // Alpha is silently discarded by the JPEG encoder.
         stbi_write_jpg_to_func(stbi_write_fwrite_callback,
                                handle,
-                               width,
-                               height,
-                               4,
-                               data,
-                               screenshots_jpg_quality);
+                               job->width,
+                               job->height,
+                               rgb != NULL ? 3 : 4,
+                               rgb != NULL ? rgb : job->data,
+                               job->level);
         fclose(handle);
     }
 
-    free(data);
+    free(rgb);
+}
+
+static int ScreenShotThread (void *data)
+{
+    shotjob_t *const job = data;
+
+    if (job->jpeg)
+    {
+        WriteJPEGfile(job);
+    }
+    else if (job->native)
+    {
+        WriteIndexedPNGfile(job);
+    }
+    else
+    {
+        WritePNGfile(job);
+    }
+
+    SDL_AtomicSet(&job->done, 1);
+
+    return 0;
+}
+
+// Wait for a job to finish and release it.
+
+static void FinishShotJob (shotjob_t *job)
+{
+    if (job->filename == NULL)
+    {
+        return;
+    }
+
+    if (job->thread != NULL)
+    {
+        SDL_WaitThread(job->thread, NULL);
+        job->thread = NULL;
+    }
+
+    free(job->data);
+    free(job->filename);
+    job->data = NULL;
+    job->filename = NULL;
+}
+
+static void V_FinishScreenShots (void)
+{
+    int i;
+
+    for (i = 0 ; i < MAXSHOTJOBS ; i++)
+    {
+        FinishShotJob(&shotjobs[i]);
+    }
+}
+
+// Find a free job slot, waiting for the oldest job if all are busy.
+
+static shotjob_t *GetShotJob (void)
+{
+    shotjob_t *oldest = NULL;
+    int i;
+
+    for (i = 0 ; i < MAXSHOTJOBS ; i++)
+    {
+        shotjob_t *const job = &shotjobs[i];
+
+        if (job->filename != NULL && SDL_AtomicGet(&job->done))
+        {
+            FinishShotJob(job);
+        }
+        if (job->filename == NULL)
+        {
+            return job;
+        }
+        if (oldest == NULL || job->sequence < oldest->sequence)
+        {
+            oldest = job;
+        }
+    }
+
+    FinishShotJob(oldest);
+
+    return oldest;
 }
 
 //
@@ -736,11 +924,15 @@ static void WriteJPEGfile(const char *filename)
 
 void V_ScreenShot(const char *format)
 {
+    static boolean atexit_set = false;
+    // [JN] Queued screenshots are not on disk yet, never reuse their names.
+    static int next_shot = 0;
     int i;
     char lbmname[16]; // haleyjd 20110213: BUG FIX - 12 is too small!
     char *file;
     const char *ext;
     boolean     use_jpeg;
+    shotjob_t  *job;
 
     // [PN] Pick the extension from the cvar, fall back to PNG on garbage.
     if (screenshots_format != NULL && (!strcasecmp(screenshots_format, "jpg")))
@@ -756,7 +948,7 @@ void V_ScreenShot(const char *format)
     
     // find a file name to save it to
 
-    for (i=0; i<=9999; i++)
+    for (i=next_shot; i<=9999; i++)
     {
         M_snprintf(lbmname, sizeof(lbmname), format, i, ext);
         // [JN] Construct full path to screenshot file.
@@ -764,17 +956,53 @@ void V_ScreenShot(const char *format)
 
         if (!M_FileExists(file))
         {
-            if (use_jpeg)
-            WriteJPEGfile(file);
-            else
-            WritePNGfile(file);
-            free(file);
-            return;
+            break;
         }
         free(file);
     }
 
-    I_Error ("V_ScreenShot: Couldn't create a screenshot.");
+    if (i > 9999)
+    {
+        I_Error ("V_ScreenShot: Couldn't create a screenshot.");
+    }
+
+    next_shot = i + 1;
+
+    if (!atexit_set)
+    {
+        I_AtExit(V_FinishScreenShots, true);
+        atexit_set = true;
+    }
+
+    job = GetShotJob();
+    job->filename = file;
+    job->jpeg = use_jpeg;
+    job->level = use_jpeg ? screenshots_jpg_quality : screenshots_png_compression;
+    job->native = screenshots_native;
+    job->sequence = shot_sequence++;
+    SDL_AtomicSet(&job->done, 0);
+
+    if (job->native)
+    {
+        job->width = SCREENWIDTH;
+        job->height = SCREENHEIGHT;
+        job->data = malloc(SCREENAREA);
+        memcpy(job->data, I_VideoBuffer, SCREENAREA);
+        I_GetPalette(job->palette);
+    }
+    else
+    {
+        I_RenderReadPixels(&job->data, &job->width, &job->height);
+    }
+
+    job->thread = SDL_CreateThread(ScreenShotThread, "screenshot", job);
+
+    // No thread, write it right away.
+    if (job->thread == NULL)
+    {
+        ScreenShotThread(job);
+        FinishShotJob(job);
+    }
 }
 
 #define MOUSE_SPEED_BOX_WIDTH  120